@@ -3,7 +3,7 @@
   * @file           : sgp41.h
   * @author         : Mauricio Barroso Benavides
   * @date           : Nov 29, 2023
-  * @brief          : todo: write brief 
+  * @brief          : Driver for the Sensirion SGP41 VOC and NOx sensor
   ******************************************************************************
   * @attention
   *
@@ -43,27 +43,339 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "sdkconfig.h"
 #include "driver/i2c_master.h"
+#include "sgp41_codec.h"
+
+#if defined(CONFIG_SGP41_LATEST) || defined(CONFIG_SGP41_QUEUE)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+
+#if defined(CONFIG_SGP41_BENCHMARK) && defined(CONFIG_SGP41_NO_HEAP)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
 
 /* Exported Macros -----------------------------------------------------------*/
 #define SGP41_I2C_ADDR						0x59
-#define SGP41_I2C_BUFFER_LEN_MAX	8
+#define SGP41_I2C_BUFFER_LEN_MAX	SGP41_CODEC_FRAME_LEN_MAX
+
+/* Commands, their arguments and responses are described in sgp41_codec.h */
+
+/* SGP41 error codes */
+#define SGP41_ERR_BASE									0xA100
+#define SGP41_ERR_WRITE_NACK						(SGP41_ERR_BASE + 1) /* Command not acknowledged */
+#define SGP41_ERR_READ_NACK							(SGP41_ERR_BASE + 2) /* Response not acknowledged */
+
+/* Self-test result bits, all zero means every pixel passed */
+#define SGP41_SELF_TEST_MASK						0x000F
+#define SGP41_SELF_TEST_VOC_FAIL				(1 << 0) /* VOC pixel failed */
+#define SGP41_SELF_TEST_NOX_FAIL				(1 << 1) /* NOx pixel failed */
+
+/* Self-test history entry: seconds since boot above the four result bits */
+#define SGP41_SELF_TEST_ENTRY_TIME_S(entry)	((entry) >> 4)
+#define SGP41_SELF_TEST_ENTRY_BITS(entry)		((entry) & SGP41_SELF_TEST_MASK)
+
+/* Sample quality flags */
+#define SGP41_SAMPLE_INVALID						(1 << 0) /* Measurement failed, see status */
+#define SGP41_SAMPLE_UNCOMPENSATED			(1 << 1) /* Measured with the default compensation */
+#define SGP41_SAMPLE_RECOVERED					(1 << 2) /* Read again after a CRC mismatch */
+#define SGP41_SAMPLE_GAP								(1 << 3) /* The slot before was given to a health check */
+#define SGP41_SAMPLE_WARM_UP						(1 << 4) /* Taken while the heater warms up */
+#define SGP41_SAMPLE_CONDITIONING				(1 << 5) /* NOx not measured, pixel being conditioned */
 
-/* SGP41 commands */
-#define SPG41_EXECUTE_CONDITIONING_CMD	0x2612
-#define SPG41_MESASURE_RAW_SIGNALS_CMD	0x2619
-#define SPG41_EXECUTE_SELF_TEST_CMD			0x280E
-#define SPG41_TURN_HEATER_FF_CMD				0x3615
-#define SPG41_GET_SERIAL_NUMBER_CMD			0x3682
+/* Health check record flags */
+#define SGP41_HEALTH_FORCED							(1 << 0) /* Ran in place of a sample */
+
+/* Default compensation, 50 %RH and 25 degC */
+#define SGP41_DEFAULT_RH								0x8000
+#define SGP41_DEFAULT_T									0x6666
+
+/* Binary log */
+#define SGP41_LOG_ARGS_MAX							3
+
+/* Latency histograms */
+#define SGP41_LATENCY_BUCKETS		20	/* Bucket i holds [2^i, 2^(i+1)) us */
 
 /* Exported typedef ----------------------------------------------------------*/
+#ifdef CONFIG_SGP41_BINARY_LOG
+typedef struct {
+	int64_t timestamp_us;											/*!< Time the message was logged */
+	uint16_t id;															/*!< Message ID, see sgp41_log_msgs.h */
+	uint32_t args[SGP41_LOG_ARGS_MAX];				/*!< Raw message arguments */
+} sgp41_log_record_t;
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+#ifdef CONFIG_SGP41_TRACE
+typedef struct {
+	int64_t timestamp_us;											/*!< Phase start time */
+	uint32_t duration_us;											/*!< Phase duration */
+	uint16_t instance;												/*!< Instance number */
+	uint8_t command;													/*!< sgp41_cmd_t */
+	uint8_t phase;														/*!< sgp41_phase_t */
+	esp_err_t status;													/*!< ESP_OK, or the error that ended the phase */
+} sgp41_trace_event_t;
+#endif /* CONFIG_SGP41_TRACE */
+
+typedef enum {
+	SGP41_PHASE_WRITE = 0,
+	SGP41_PHASE_WAIT,
+	SGP41_PHASE_READ,
+	SGP41_PHASE_CRC,
+	SGP41_PHASE_QUEUE,												/* Time a request waited in the queue */
+	SGP41_PHASE_MAX
+} sgp41_phase_t;
+
+typedef enum {
+	SGP41_WAIT_BUSY = 0,											/*!< Spin on esp_timer, exact */
+	SGP41_WAIT_TASK_DELAY,										/*!< Block with vTaskDelay(), up to 2 ticks more */
+	SGP41_WAIT_MAX
+} sgp41_wait_t;
+
+#ifdef CONFIG_SGP41_LATENCY_STATS
 typedef struct {
+	uint32_t count;													/*!< Number of samples */
+	uint32_t failures;											/*!< Samples of phases that failed */
+	uint32_t max_us;												/*!< Longest sample in us */
+	uint64_t sum_us;												/*!< Sum of all samples in us */
+	uint32_t buckets[SGP41_LATENCY_BUCKETS];	/*!< Log2 buckets, 0 us goes to bucket 0 */
+} sgp41_latency_hist_t;
+
+typedef struct {
+	sgp41_latency_hist_t hist[SGP41_CMD_MAX][SGP41_PHASE_MAX];
+} sgp41_latency_stats_t;
+#endif /* CONFIG_SGP41_LATENCY_STATS */
+
+#ifdef CONFIG_SGP41_METRICS
+typedef struct {
+	uint32_t crc_errors[SGP41_RESPONSE_WORDS_MAX];	/*!< CRC mismatches per response word */
+	uint32_t write_nacks;											/*!< Command writes not acknowledged */
+	uint32_t read_nacks;											/*!< Response reads not acknowledged */
+	uint32_t timeouts;												/*!< I2C transactions timed out */
+	uint32_t self_test_failures;							/*!< Self tests with a failed pixel */
+	uint32_t voc_pixel_failures;							/*!< Self tests with a failed VOC pixel */
+	uint32_t nox_pixel_failures;							/*!< Self tests with a failed NOx pixel */
+	uint32_t crc_retries;											/*!< Responses read again after a CRC mismatch */
+	uint32_t crc_recoveries;									/*!< Commands that succeeded after retrying */
+	uint32_t health_skips;										/*!< Sample slots given to a health check */
+} sgp41_counters_t;
+
+typedef struct {
+	const char *name;													/*!< Counter name, snake case */
+	const char *help;													/*!< Counter description */
+	size_t offset;														/*!< Offset inside sgp41_counters_t */
+} sgp41_metric_desc_t;
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_CPU_STATS
+typedef struct {
+	uint64_t spin_us[SGP41_CMD_MAX];					/*!< CPU time busy-waiting in delay_us() */
+	uint64_t i2c_us[SGP41_CMD_MAX];						/*!< Time spent in I2C writes and reads */
+	uint32_t commands[SGP41_CMD_MAX];					/*!< Commands issued */
+} sgp41_cpu_stats_t;
+#endif /* CONFIG_SGP41_CPU_STATS */
+
+#ifdef CONFIG_SGP41_HOOKS
+typedef struct {
+	int64_t (*now_us)(void *ctx);							/*!< Monotonic time in us */
+	void (*wait_us)(void *ctx, uint32_t period_us);	/*!< Wait for the sensor */
+	void *ctx;																/*!< Passed to both callbacks */
+} sgp41_clock_t;
+
+typedef struct {
+	esp_err_t (*write)(void *ctx, const uint8_t *data, size_t len);	/*!< Send a command frame */
+	esp_err_t (*read)(void *ctx, uint8_t *data, size_t len);				/*!< Read a response */
+	void *ctx;																/*!< Passed to both callbacks */
+} sgp41_transport_t;
+#endif /* CONFIG_SGP41_HOOKS */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+typedef struct {
+	uint32_t period_ms;												/*!< Target sampling period */
+	uint32_t samples;													/*!< Samples per scheduling mode */
+	uint32_t deadline_us;											/*!< Allowed lateness of a sample */
+	bool cpu_load;														/*!< Run a competing CPU-bound task */
+	i2c_master_bus_handle_t load_bus;					/*!< Bus to load with probes, or NULL */
+	uint16_t load_addr;												/*!< Address probed on load_bus */
+	uint8_t load_duty_pct;										/*!< Share of the time load_bus is probed,
+																							 0 for back-to-back probes */
+	uint32_t *buffer;													/*!< Room for samples - 1 values, NULL to
+																							 allocate it (not with SGP41_NO_HEAP) */
+} sgp41_jitter_config_t;
+#endif /* CONFIG_SGP41_BENCHMARK */
+
+#ifdef CONFIG_SGP41_HEATER
+typedef enum {
+	SGP41_HEATER_OFF = 0,											/*!< Idle, after init, heater off or self test */
+	SGP41_HEATER_CONDITIONING,								/*!< NOx pixel being conditioned */
+	SGP41_HEATER_WARMING_UP,									/*!< Measuring, signals not settled yet */
+	SGP41_HEATER_ON,													/*!< Measuring, warm-up over */
+	SGP41_HEATER_STATE_MAX
+} sgp41_heater_state_t;
+#endif /* CONFIG_SGP41_HEATER */
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+typedef struct {
+	uint64_t total_us;												/*!< Time since the instance was started */
+	uint64_t on_us;														/*!< Time with the heater on */
+	uint16_t duty_permille;										/*!< on_us over total_us */
+	uint64_t energy_uj;												/*!< Estimated sensor energy */
+	uint32_t idle_offs;												/*!< Heater turned off for lack of demand */
+	uint32_t prewarms;												/*!< Heater turned on ahead of a need */
+} sgp41_heater_power_stats_t;
+#endif /* CONFIG_SGP41_HEATER_POWER */
+
+typedef enum {
+	SGP41_PIXEL_VOC = 0,
+	SGP41_PIXEL_NOX,
+	SGP41_PIXEL_MAX
+} sgp41_pixel_t;
+
+typedef struct {
+	int64_t timestamp_us;											/*!< Time of the test, 0 if none yet */
+	uint16_t raw;															/*!< Result word returned by the sensor */
+	bool pixel_ok[SGP41_PIXEL_MAX];						/*!< Pass/fail of each pixel */
+} sgp41_self_test_t;
+
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+typedef struct {
+	uint16_t tests;														/*!< Self tests in the history */
+	uint16_t failures[SGP41_PIXEL_MAX];				/*!< Failures of each pixel among them */
+	uint16_t streak[SGP41_PIXEL_MAX];					/*!< Latest consecutive failures of each pixel */
+} sgp41_self_test_trend_t;
+#endif /* CONFIG_SGP41_SELF_TEST_HISTORY */
+
+#ifdef CONFIG_SGP41_HEALTH
+typedef struct {
+	int64_t timestamp_us;											/*!< Time the check finished */
+	esp_err_t status;													/*!< Result of the self test command */
+	uint16_t test_result;											/*!< Self test result, see sgp41_execute_self_test() */
+	uint8_t flags;														/*!< SGP41_HEALTH_* flags */
+} sgp41_health_record_t;
+#endif /* CONFIG_SGP41_HEALTH */
+
+typedef struct {
+	int64_t timestamp_us;											/*!< Time the response was read */
+	uint32_t seq;															/*!< Per-instance sequence number */
+	esp_err_t status;													/*!< Result of the measurement */
+	uint16_t sraw_voc;												/*!< VOC raw signal */
+	uint16_t sraw_nox;												/*!< NOx raw signal */
+	uint16_t relative_humidity;								/*!< Humidity compensation sent */
+	uint16_t temperature;											/*!< Temperature compensation sent */
+	uint8_t flags;														/*!< SGP41_SAMPLE_* quality flags */
+} sgp41_sample_t;
+
+typedef struct sgp41_s {
 	i2c_master_dev_handle_t i2c_dev;					/*!< I2C device handle */
+	uint16_t id;															/*!< Instance number, in init order */
+	uint32_t seq;															/*!< Sequence number of the next sample */
+	sgp41_wait_t wait;												/*!< How commands wait for the sensor */
+	sgp41_self_test_t self_test;							/*!< Latest self test result */
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+	uint32_t self_test_head;									/*!< Self tests recorded */
+	uint32_t self_test_history[CONFIG_SGP41_SELF_TEST_HISTORY_SIZE];	/*!< Latest results, see
+																							 SGP41_SELF_TEST_ENTRY_* */
+#endif
+#ifdef CONFIG_SGP41_HEATER
+	sgp41_heater_state_t heater_state;				/*!< Heater state */
+	int64_t heater_on_us;											/*!< Time the heater was turned on */
+#endif
+#ifdef CONFIG_SGP41_HEATER_POWER
+	int64_t power_start_us;										/*!< Start of the power accounting */
+	uint64_t power_on_us;											/*!< Heater on time, current period excluded */
+	int64_t demand_us;												/*!< Time of the latest sample */
+	int64_t need_us;													/*!< Next scheduled need, 0 if none */
+	uint32_t idle_offs;												/*!< Heater turned off for lack of demand */
+	uint32_t prewarms;												/*!< Heater turned on ahead of a need */
+#endif
+#ifdef CONFIG_SGP41_CRC_RETRY
+	uint8_t retries;													/*!< Retries of the latest command */
+#endif
+#ifdef CONFIG_SGP41_HOOKS
+	const sgp41_transport_t *transport;				/*!< Custom transport, NULL for I2C */
+#endif
+#ifdef CONFIG_SGP41_METRICS
+	sgp41_counters_t counters;								/*!< Error counters */
+	uint16_t sraw_voc;												/*!< Latest VOC raw signal */
+	uint16_t sraw_nox;												/*!< Latest NOx raw signal */
+	int64_t sample_us;												/*!< Time of the latest sample */
+	struct sgp41_s *next;											/*!< Next registered instance */
+#endif
+#if defined(CONFIG_SGP41_METRICS) && defined(CONFIG_SGP41_BENCHMARK)
+	sgp41_counters_t stress_counters;					/*!< Counters when the stress run started */
+#endif
+#ifdef CONFIG_SGP41_LATENCY_STATS
+	sgp41_latency_stats_t latency;						/*!< Per-command latency histograms */
+#endif
+#ifdef CONFIG_SGP41_CPU_STATS
+	sgp41_cpu_stats_t cpu;										/*!< Busy-wait and I2C time */
+#endif
+#ifdef CONFIG_SGP41_LATEST
+	sgp41_sample_t latest;										/*!< Sample shared by sgp41_get_latest() */
+	bool latest_valid;												/*!< True while latest holds a good sample */
+	uint32_t latest_generation;								/*!< Measurements made for the callers */
+	SemaphoreHandle_t latest_lock;						/*!< Serializes the shared measurement */
+	StaticSemaphore_t latest_lock_buffer;			/*!< Storage of latest_lock */
+#endif
+#ifdef CONFIG_SGP41_HEALTH
+	int64_t health_due_us;										/*!< Time the next health check is due */
+	bool health_gap;													/*!< The next sample follows a skipped slot */
+	uint32_t health_head;											/*!< Health checks recorded */
+	sgp41_health_record_t health[CONFIG_SGP41_HEALTH_HISTORY_SIZE];	/*!< Latest health checks */
+#endif
+#ifdef CONFIG_SGP41_QUEUE
+	struct sgp41_request_s *queue;						/*!< Pending requests, oldest first */
+	portMUX_TYPE queue_lock;									/*!< Protects queue */
+	SemaphoreHandle_t queue_owner;						/*!< Held by the task serving the queue */
+	StaticSemaphore_t queue_owner_buffer;			/*!< Storage of queue_owner */
+#endif
 } sgp41_t;
 
+/* Static memory, to budget RAM at compile time. Instances are provided by the
+ * caller, the rings are owned by the driver and nothing is allocated after
+ * sgp41_init() */
+#define SGP41_INSTANCE_SIZE							sizeof(sgp41_t)
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+#define SGP41_LOG_RING_BYTES						(CONFIG_SGP41_BINARY_LOG_RING_SIZE * \
+		(sizeof(sgp41_log_record_t) + sizeof(uint32_t)))
+#else
+#define SGP41_LOG_RING_BYTES						0
+#endif
+
+#ifdef CONFIG_SGP41_TRACE
+#define SGP41_TRACE_RING_BYTES					(CONFIG_SGP41_TRACE_RING_SIZE * \
+		(sizeof(sgp41_trace_event_t) + sizeof(uint32_t)))
+#else
+#define SGP41_TRACE_RING_BYTES					0
+#endif
+
+#ifdef CONFIG_SGP41_POOLS
+#define SGP41_SAMPLE_POOL_BYTES					(CONFIG_SGP41_SAMPLE_POOL_SIZE * \
+		(sizeof(sgp41_sample_t) + sizeof(uint16_t)))
+#else
+#define SGP41_SAMPLE_POOL_BYTES					0
+#endif
+
+/* Load tasks of sgp41_benchmark_jitter(), static with SGP41_NO_HEAP */
+#define SGP41_BENCHMARK_LOAD_TASKS			2
+#define SGP41_BENCHMARK_LOAD_STACK_SIZE	2048
+
+#if defined(CONFIG_SGP41_BENCHMARK) && defined(CONFIG_SGP41_NO_HEAP)
+#define SGP41_BENCHMARK_BYTES						(SGP41_BENCHMARK_LOAD_TASKS * \
+		(SGP41_BENCHMARK_LOAD_STACK_SIZE * sizeof(StackType_t) + sizeof(StaticTask_t)))
+#else
+#define SGP41_BENCHMARK_BYTES						0
+#endif
+
+#define SGP41_STATIC_BYTES							(SGP41_LOG_RING_BYTES + \
+		SGP41_TRACE_RING_BYTES + SGP41_SAMPLE_POOL_BYTES + SGP41_BENCHMARK_BYTES)
+
 /* Exported variables --------------------------------------------------------*/
 
 /* Exported functions prototypes ---------------------------------------------*/
@@ -75,11 +387,70 @@ typedef struct {
  * 								   I2C device
  * @param dev_addr : I2C device address
  *
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT, ESP_ERR_INVALID_CRC,
+ * SGP41_ERR_WRITE_NACK or SGP41_ERR_READ_NACK on communication failure. On
+ * failure the device is removed from the bus and sgp41_deinit() is not needed.
  */
 esp_err_t sgp41_init(sgp41_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
 		uint8_t dev_addr);
 
+/**
+ * @brief Function that releases a SGP41 instance: it is removed from the
+ * metrics registry, waiting for exporters that hold sgp41_metrics_acquire(),
+ * and its device from the I2C bus. The instance must not be in use by other
+ * tasks. Releasing an instance again, e.g. after a failed init, does nothing.
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if me is NULL or the error of
+ * i2c_master_bus_rm_device()
+ */
+esp_err_t sgp41_deinit(sgp41_t *const me);
+
+#ifdef CONFIG_SGP41_HOOKS
+/**
+ * @brief Function that initializes a SGP41 instance that talks through a
+ * custom transport instead of the I2C master driver, e.g. a simulated sensor
+ *
+ * @param me        : Pointer to a sgp41_t instance
+ * @param transport : Pointer to the transport, must outlive the instance
+ *
+ * @return ESP_OK on success, an error code otherwise. On failure nothing is
+ * left to release.
+ */
+esp_err_t sgp41_init_with_transport(sgp41_t *const me,
+		                                const sgp41_transport_t *transport);
+
+/**
+ * @brief Function that replaces the time source and the waits of the driver
+ * for every instance. With a virtual clock whose wait advances time instantly,
+ * hours of sampling run in seconds and give the same results on every run.
+ * SGP41_WAIT_TASK_DELAY waits on it up to the tick boundary vTaskDelay()
+ * would end on, ticks being counted from time 0 of the clock.
+ * The clock is a global read without locking, so call this function only
+ * while no instance is initialized, i.e. before the first sgp41_init() or
+ * sgp41_init_with_transport() or after every instance was released.
+ *
+ * @param clock : Pointer to the clock, copied, or NULL to restore esp_timer
+ *                and busy-waiting
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_set_clock(const sgp41_clock_t *clock);
+#endif /* CONFIG_SGP41_HOOKS */
+
+/**
+ * @brief Function that selects how an instance waits while the sensor
+ * processes a command. Instances start with the strategy chosen in Kconfig.
+ * Call it while no command of the instance is in progress.
+ *
+ * @param me   : Pointer to a sgp41_t instance
+ * @param wait : Wait strategy
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the strategy is unknown
+ */
+esp_err_t sgp41_set_wait(sgp41_t *const me, sgp41_wait_t wait);
+
 /**
  * @brief Function that starts the conditioning, i.e., the VOC pixel will be
  * operated at the same temperature as it is by calling the sgp41_measure_raw
@@ -123,6 +494,110 @@ esp_err_t sgp41_measure_raw_signals(sgp41_t *const me, uint16_t relative_humidit
 		                                uint16_t temperature, uint16_t *sraw_voc,
 																		uint16_t *sraw_nox);
 
+/**
+ * @brief Function that measures the VOC and NOx raw signals and returns them
+ * with their timestamp, compensation, status and sequence number
+ *
+ * @param me                : Pointer to a sgp41_t instance
+ * @param relative_humidity : Humidity compensation, see
+ * sgp41_measure_raw_signals()
+ * @param temperature       : Temperature compensation, see
+ * sgp41_measure_raw_signals()
+ * @param sample            : Pointer where the sample is stored, also on
+ * failure with SGP41_SAMPLE_INVALID set. With SGP41_CRC_RETRY, a sample read
+ * again after a CRC mismatch has SGP41_SAMPLE_RECOVERED set. With
+ * SGP41_HEATER_AUTO_CONDITIONING, the conditioning command is sent instead
+ * until the NOx pixel is conditioned and the sample has
+ * SGP41_SAMPLE_CONDITIONING set and no NOx signal.
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sgp41_measure(sgp41_t *const me, uint16_t relative_humidity,
+		                    uint16_t temperature, sgp41_sample_t *sample);
+
+/**
+ * @brief Function that measures several instances in one call. The commands
+ * are written to every instance, the processing time is waited once and the
+ * responses are read, so count instances take about as long as one.
+ *
+ * @param instances         : Array of count instances
+ * @param count             : Number of instances
+ * @param relative_humidity : Humidity compensation sent to every instance
+ * @param temperature       : Temperature compensation sent to every instance
+ * @param samples           : Array of count samples, filled in order
+ *
+ * @return ESP_OK if every measurement succeeded, the first error otherwise
+ */
+esp_err_t sgp41_measure_batch(sgp41_t *const *instances, size_t count,
+		                          uint16_t relative_humidity, uint16_t temperature,
+															sgp41_sample_t *samples);
+
+#ifdef CONFIG_SGP41_LATEST
+/**
+ * @brief Function that returns the latest sample if it is at most max_age_ms
+ * old, otherwise measures a new one. Tasks calling it at the same time wait
+ * for the measurement in progress and share its result instead of starting
+ * their own, so the bus traffic follows the demand and not the number of
+ * callers. A failed measurement is shared with the callers that waited for
+ * it but is not kept, the next call measures again.
+ *
+ * @param me                : Pointer to a sgp41_t instance
+ * @param max_age_ms        : Oldest sample accepted
+ * @param relative_humidity : Humidity compensation of a new measurement
+ * @param temperature       : Temperature compensation of a new measurement
+ * @param sample            : Pointer where the sample is stored
+ *
+ * @return Status of the sample returned
+ */
+esp_err_t sgp41_get_latest(sgp41_t *const me, uint32_t max_age_ms,
+		                       uint16_t relative_humidity, uint16_t temperature,
+													 sgp41_sample_t *sample);
+#endif /* CONFIG_SGP41_LATEST */
+
+#ifdef CONFIG_SGP41_QUEUE
+/**
+ * @brief Function that queues a command and waits for its result. The first
+ * caller that finds the instance idle serves the queue, highest priority
+ * first. Pending requests for the same command are merged into one bus
+ * transaction, with the arguments of the most recent request, and all of them
+ * get its result. Commands run through the same functions as direct calls,
+ * so a queued self test is decoded and counted, and a queued measurement
+ * returns SRAW_VOC and SRAW_NOX in rx. The time each request waited is
+ * recorded as SGP41_PHASE_QUEUE in the latency statistics and the trace.
+ *
+ * The priority argument only orders the queue. The task serving it runs at
+ * the highest FreeRTOS priority of the tasks waiting on it, from the next
+ * transaction on, and returns to its own priority when the queue is empty.
+ *
+ * @param me       : Pointer to a sgp41_t instance
+ * @param cmd      : Command to execute
+ * @param priority : Higher values are served first, FIFO among equals
+ * @param tx       : Pointer to the argument words, NULL if the command has none
+ * @param rx       : Pointer where the response words are stored, NULL if the
+ *                   command has none
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sgp41_request(sgp41_t *const me, sgp41_cmd_t cmd, uint8_t priority,
+		                    const uint16_t *tx, uint16_t *rx);
+
+/**
+ * @brief Function that queues a measurement, see sgp41_request(). Merged
+ * measurements return the same sample.
+ *
+ * @param me                : Pointer to a sgp41_t instance
+ * @param priority          : Higher values are served first
+ * @param relative_humidity : Humidity compensation
+ * @param temperature       : Temperature compensation
+ * @param sample            : Pointer where the sample is stored
+ *
+ * @return Status of the sample
+ */
+esp_err_t sgp41_request_measure(sgp41_t *const me, uint8_t priority,
+		                            uint16_t relative_humidity,
+																uint16_t temperature, sgp41_sample_t *sample);
+#endif /* CONFIG_SGP41_QUEUE */
+
 /**
  * @brief Function that triggers the built-in self-test checking for integrity
  * of both hotplate and MOX material and returns the result of this test as 2
@@ -139,6 +614,78 @@ esp_err_t sgp41_measure_raw_signals(sgp41_t *const me, uint16_t relative_humidit
  */
 esp_err_t sgp41_execute_self_test(sgp41_t *const me, uint16_t *test_result);
 
+/**
+ * @brief Function that decodes the pixel pass/fail bits of a self test result.
+ * The result of every self test is also decoded into me->self_test.
+ *
+ * @param test_result : Result returned by sgp41_execute_self_test()
+ * @param self_test   : Pointer where the decoded result is stored, without
+ *                      timestamp
+ */
+void sgp41_self_test_decode(uint16_t test_result, sgp41_self_test_t *self_test);
+
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+/**
+ * @brief Function that copies the self test history of an instance, oldest
+ * first. Each entry packs the test time and the result bits, read them with
+ * SGP41_SELF_TEST_ENTRY_TIME_S() and SGP41_SELF_TEST_ENTRY_BITS().
+ *
+ * @param me          : Pointer to a sgp41_t instance
+ * @param entries     : Pointer to the array where the entries are copied
+ * @param entries_len : Capacity of the array
+ *
+ * @return Number of entries copied
+ */
+size_t sgp41_self_test_get_history(const sgp41_t *const me, uint32_t *entries,
+		                               size_t entries_len);
+
+/**
+ * @brief Function that summarizes the self test history of an instance per
+ * pixel: failures over the history and failures in a row up to the latest
+ * test. A rising failure count on one pixel shows it degrading.
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param trend : Pointer where the summary is stored
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_self_test_get_trend(const sgp41_t *const me,
+		                                sgp41_self_test_trend_t *trend);
+#endif /* CONFIG_SGP41_SELF_TEST_HISTORY */
+
+#ifdef CONFIG_SGP41_HEALTH
+/**
+ * @brief Function that runs the periodic health check, a self test, in a gap
+ * of the sampling schedule. Call it from the sampling task after each sample
+ * with the time left until the next one. A due check runs in the first gap
+ * long enough for the self test (320 ms). When no gap was long enough for
+ * SGP41_HEALTH_MAX_DELAY_S, it runs anyway: the next sample is late, it is
+ * flagged with SGP41_SAMPLE_GAP and the check with SGP41_HEALTH_FORCED.
+ *
+ * @param me     : Pointer to a sgp41_t instance
+ * @param gap_ms : Time until the next sample is due
+ * @param ran    : Pointer where true is stored if a check ran, may be NULL
+ *
+ * @return ESP_OK if no check was due or it passed the self test command, the
+ * error of the self test command otherwise
+ */
+esp_err_t sgp41_health_poll(sgp41_t *const me, uint32_t gap_ms, bool *ran);
+
+/**
+ * @brief Function that copies the latest health checks of an instance, oldest
+ * first
+ *
+ * @param me          : Pointer to a sgp41_t instance
+ * @param records     : Pointer to the array where the records are copied
+ * @param records_len : Capacity of the array
+ *
+ * @return Number of records copied
+ */
+size_t sgp41_health_get_history(const sgp41_t *const me,
+		                            sgp41_health_record_t *records,
+																size_t records_len);
+#endif /* CONFIG_SGP41_HEALTH */
+
 /**
  * @brief Function that turns the hotplate off and stops the
  * measurement. Subsequently, the sensor enters the idle mode.
@@ -149,6 +696,62 @@ esp_err_t sgp41_execute_self_test(sgp41_t *const me, uint16_t *test_result);
  */
 esp_err_t sgp41_turn_heater_off(sgp41_t *const me);
 
+#ifdef CONFIG_SGP41_HEATER
+/**
+ * @brief Function that returns the heater state of an instance. The state
+ * follows the commands sent: measurement and conditioning turn the heater on,
+ * sgp41_turn_heater_off() and the self test leave the sensor idle. Samples
+ * taken less than SGP41_HEATER_WARM_UP_MS after the heater was turned on are
+ * flagged with SGP41_SAMPLE_WARM_UP.
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param on_ms : Pointer where the time since the heater was turned on is
+ *                stored, 0 when it is off, may be NULL
+ *
+ * @return Heater state
+ */
+sgp41_heater_state_t sgp41_heater_get_state(sgp41_t *const me, uint32_t *on_ms);
+#endif /* CONFIG_SGP41_HEATER */
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+/**
+ * @brief Function that runs the heater power manager of an instance. Call it
+ * about once per second from the task that uses the instance. The heater is
+ * turned off when no sample was taken for SGP41_HEATER_IDLE_TIMEOUT_S, and
+ * turned on ahead of the need set with sgp41_heater_schedule() so the warm-up,
+ * and the conditioning if enabled, is over by then.
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return ESP_OK on success, the error of the command sent otherwise
+ */
+esp_err_t sgp41_heater_poll(sgp41_t *const me);
+
+/**
+ * @brief Function that sets when data will be needed next, e.g. the start of
+ * the occupied hours. It is forgotten once that time has passed.
+ *
+ * @param me      : Pointer to a sgp41_t instance
+ * @param need_us : Time of the need in the driver time base (esp_timer, or
+ *                  the clock set with sgp41_set_clock()), 0 to clear it
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_heater_schedule(sgp41_t *const me, int64_t need_us);
+
+/**
+ * @brief Function that returns the heater duty cycle of an instance and the
+ * sensor energy estimated from the currents set in Kconfig
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param stats : Pointer where the statistics are stored
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_heater_get_power_stats(sgp41_t *const me,
+		                                   sgp41_heater_power_stats_t *stats);
+#endif /* CONFIG_SGP41_HEATER_POWER */
+
 /**
  * @brief Function that provides the decimal serial number of the SGP41 chip by
  * returning 3x2 bytes.
@@ -160,6 +763,258 @@ esp_err_t sgp41_turn_heater_off(sgp41_t *const me);
  */
 esp_err_t sgp41_get_serial_number(sgp41_t *const me, uint16_t *serial_number);
 
+/**
+ * @brief Function that returns the name of a command, e.g. "measure"
+ *
+ * @param cmd : Command
+ *
+ * @return Constant string, "unknown" if the command is out of range
+ */
+const char *sgp41_cmd_name(sgp41_cmd_t cmd);
+
+/**
+ * @brief Function that returns the name of a command phase, e.g. "wait"
+ *
+ * @param phase : Command phase
+ *
+ * @return Constant string, "unknown" if the phase is out of range
+ */
+const char *sgp41_phase_name(sgp41_phase_t phase);
+
+#ifdef CONFIG_SGP41_METRICS
+/**
+ * @brief Function that returns the table of counters exposed by every
+ * instance. The table is constant, so it can be cached by the caller.
+ *
+ * @param count : Pointer where the number of counters is stored
+ *
+ * @return Pointer to the first counter descriptor
+ */
+const sgp41_metric_desc_t *sgp41_metrics_get_descs(size_t *count);
+
+/**
+ * @brief Function that reads one counter of a SGP41 instance
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param index : Index of the counter in the descriptor table
+ *
+ * @return Counter value, 0 if the index is out of range
+ */
+uint32_t sgp41_metrics_read(const sgp41_t *const me, size_t index);
+
+/**
+ * @brief Function that keeps the registered instances from being released
+ * until sgp41_metrics_release(): sgp41_deinit() waits for it. Hold it while
+ * walking the instances and reading them, and release it before blocking.
+ */
+void sgp41_metrics_acquire(void);
+
+/**
+ * @brief Function that allows the registered instances to be released again,
+ * see sgp41_metrics_acquire()
+ */
+void sgp41_metrics_release(void);
+
+/**
+ * @brief Function that returns the first registered SGP41 instance. Instances
+ * are registered by sgp41_init(), newest first, so ids decrease along the
+ * list. Call it with sgp41_metrics_acquire() held.
+ *
+ * @return Pointer to a sgp41_t instance, NULL if there are none
+ */
+sgp41_t *sgp41_metrics_first_instance(void);
+
+/**
+ * @brief Function that returns the registered instance following another one.
+ * Call it with sgp41_metrics_acquire() held.
+ *
+ * @param me : Pointer to a registered sgp41_t instance
+ *
+ * @return Pointer to a sgp41_t instance, NULL at the end of the list
+ */
+sgp41_t *sgp41_metrics_next_instance(const sgp41_t *const me);
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+/**
+ * @brief Function that times the driver hot paths (CRC generation and check,
+ * command frame encoding, response decoding) and, when an instance is given,
+ * full measurement round trips. Every result is printed to the stream as one
+ * JSON object per line so runs can be compared across driver versions.
+ *
+ * @param me         : Pointer to an initialized sgp41_t instance, or NULL to
+ *                     skip the round trips
+ * @param iterations : Number of operations per benchmark, round trips are
+ *                     capped at 20
+ * @param stream     : Stream where the results are printed
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if another benchmark is
+ * running
+ */
+esp_err_t sgp41_benchmark_run(sgp41_t *const me, uint32_t iterations,
+		                          FILE *stream);
+
+/**
+ * @brief Function that runs a sampling loop with every wait strategy and
+ * every scheduling mode (a delay for the rest of each period, and
+ * xTaskDelayUntil), optionally while a competing task loads the CPU and
+ * another one probes a bus for a share of the time. For each combination the
+ * p50/p99/max deviation from the target period, the samples started later
+ * than the deadline on the ideal grid and the longest measurement are printed
+ * as one JSON line. The instance keeps its own wait strategy afterwards. With
+ * a clock set by sgp41_set_clock() the loop is timed and paced by that clock,
+ * on ticks derived from it, so a simulated sensor gives the same results on
+ * every run. The load tasks still run on esp_timer and do not move that
+ * clock.
+ *
+ * @param me     : Pointer to an initialized sgp41_t instance, also one created
+ *                 with sgp41_init_with_transport()
+ * @param config : Pointer to the scenario to run
+ * @param stream : Stream where the results are printed
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the samples do not fit,
+ * ESP_ERR_INVALID_ARG if no buffer is given with SGP41_NO_HEAP or the duty
+ * cycle is above 100 %,
+ * ESP_ERR_INVALID_STATE if another benchmark is running
+ */
+esp_err_t sgp41_benchmark_jitter(sgp41_t *const me,
+		                             const sgp41_jitter_config_t *config,
+																 FILE *stream);
+
+/**
+ * @brief Function that measures many instances back to back, e.g. sensors
+ * spread over several buses and mux channels or simulated ones created with
+ * sgp41_init_with_transport(), and prints one JSON line with the throughput,
+ * the errors by kind, the size of each instance and the heap use: the free
+ * heap before and after the run and the peak taken during it, measured from
+ * a baseline taken when the run starts. With metrics enabled, every instance
+ * that saw errors during the run gets its own line with the counters it
+ * gained, counts from before the run are left out.
+ *
+ * @param instances : Pointer to an array of initialized instances
+ * @param count     : Number of instances
+ * @param rounds    : Number of times every instance is measured
+ * @param stream    : Stream where the results are printed
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if another benchmark is
+ * running
+ */
+esp_err_t sgp41_benchmark_stress(sgp41_t *const *instances, size_t count,
+		                             uint32_t rounds, FILE *stream);
+#endif /* CONFIG_SGP41_BENCHMARK */
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+/**
+ * @brief Function that copies the recorded log messages, oldest first
+ *
+ * @param records     : Pointer to the array where the records are copied
+ * @param records_len : Capacity of the array
+ *
+ * @return Number of records copied
+ */
+size_t sgp41_log_snapshot(sgp41_log_record_t *records, size_t records_len);
+
+/**
+ * @brief Function that prints the recorded log messages, one raw record per
+ * line. The output is formatted on the host with tools/sgp41_log_decode.py.
+ *
+ * @param stream : Stream where the records are printed
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_log_dump(FILE *stream);
+
+/**
+ * @brief Function that discards every recorded log message
+ */
+void sgp41_log_clear(void);
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+#ifdef CONFIG_SGP41_TRACE
+/**
+ * @brief Function that copies the recorded bus transactions of all instances,
+ * oldest first
+ *
+ * @param events     : Pointer to the array where the events are copied
+ * @param events_len : Capacity of the array
+ *
+ * @return Number of events copied
+ */
+size_t sgp41_trace_snapshot(sgp41_trace_event_t *events, size_t events_len);
+
+/**
+ * @brief Function that prints the recorded bus transactions as Chrome trace
+ * event JSON, which can be loaded in chrome://tracing or Perfetto. Each
+ * instance is shown as its own thread, failed phases carry their error in the
+ * event arguments.
+ *
+ * @param stream : Stream where the JSON document is printed
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_trace_dump_json(FILE *stream);
+
+/**
+ * @brief Function that prints the recorded bus transactions as one line per
+ * event, cheaper than JSON on the device. tools/sgp41_trace_to_chrome.py turns
+ * a console capture of it into Chrome trace event JSON.
+ *
+ * @param stream : Stream where the events are printed
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_trace_dump(FILE *stream);
+
+/**
+ * @brief Function that discards every recorded bus transaction
+ */
+void sgp41_trace_clear(void);
+#endif /* CONFIG_SGP41_TRACE */
+
+#ifdef CONFIG_SGP41_CPU_STATS
+/**
+ * @brief Function that copies the CPU time a SGP41 instance has spent
+ * busy-waiting for the sensor, next to the time spent on the I2C bus
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param stats : Pointer to the structure where the snapshot is stored
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_get_cpu_stats(sgp41_t *const me, sgp41_cpu_stats_t *stats);
+
+/**
+ * @brief Function that clears the CPU time accounting of a SGP41 instance
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_reset_cpu_stats(sgp41_t *const me);
+#endif /* CONFIG_SGP41_CPU_STATS */
+
+#ifdef CONFIG_SGP41_LATENCY_STATS
+/**
+ * @brief Function that copies the latency histograms of a SGP41 instance
+ *
+ * @param me    : Pointer to a sgp41_t instance
+ * @param stats : Pointer to the structure where the snapshot is stored
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_get_latency_stats(sgp41_t *const me,
+		                              sgp41_latency_stats_t *stats);
+
+/**
+ * @brief Function that clears the latency histograms of a SGP41 instance
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_reset_latency_stats(sgp41_t *const me);
+#endif /* CONFIG_SGP41_LATENCY_STATS */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,674 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41.hpp
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Header-only policy-based SGP41 driver
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_HPP_
+#define SGP41_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "sgp41_codec.h"
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+#define SGP41_HPP_EXPECTED 1
+#include <expected>
+#endif
+
+#if __has_include("driver/i2c_master.h")
+#define SGP41_HPP_ESP_IDF 1
+#include <memory>
+#include <new>
+#include "sgp41.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+namespace sgp41 {
+
+/* Exported constants --------------------------------------------------------*/
+/* Status codes, equal to the esp_err_t values returned by the C driver */
+using status_t = int32_t;
+
+inline constexpr status_t ok = 0;
+inline constexpr status_t no_mem = 0x101;									/* ESP_ERR_NO_MEM */
+inline constexpr status_t invalid_arg = 0x102;						/* ESP_ERR_INVALID_ARG */
+inline constexpr status_t invalid_state = 0x103;					/* ESP_ERR_INVALID_STATE */
+inline constexpr status_t timeout = 0x107;								/* ESP_ERR_TIMEOUT */
+inline constexpr status_t invalid_crc = 0x109;						/* ESP_ERR_INVALID_CRC */
+inline constexpr status_t write_nack = 0xA101;						/* SGP41_ERR_WRITE_NACK */
+inline constexpr status_t read_nack = 0xA102;							/* SGP41_ERR_READ_NACK */
+
+/* Commands */
+inline constexpr uint16_t execute_conditioning_cmd = 0x2612;
+inline constexpr uint16_t measure_raw_signals_cmd = 0x2619;
+inline constexpr uint16_t execute_self_test_cmd = 0x280E;
+inline constexpr uint16_t turn_heater_off_cmd = 0x3615;
+inline constexpr uint16_t get_serial_number_cmd = 0x3682;
+
+/* Processing time of each command */
+inline constexpr std::chrono::milliseconds conditioning_time{50};
+inline constexpr std::chrono::milliseconds measure_time{50};
+inline constexpr std::chrono::milliseconds self_test_time{320};
+inline constexpr std::chrono::milliseconds heater_off_time{1};
+inline constexpr std::chrono::milliseconds serial_number_time{1};
+
+/* Default compensation, 50 %RH and 25 degC */
+inline constexpr uint16_t default_rh = 0x8000;
+inline constexpr uint16_t default_t = 0x6666;
+
+/* Sample flags */
+inline constexpr uint8_t sample_uncompensated = 1 << 1;
+inline constexpr uint8_t sample_recovered = 1 << 2;
+inline constexpr uint8_t sample_gap = 1 << 3;
+inline constexpr uint8_t sample_warm_up = 1 << 4;
+inline constexpr uint8_t sample_conditioning = 1 << 5;
+
+#ifdef SGP41_HPP_ESP_IDF
+static_assert(no_mem == ESP_ERR_NO_MEM && invalid_arg == ESP_ERR_INVALID_ARG &&
+		invalid_state == ESP_ERR_INVALID_STATE &&
+		timeout == ESP_ERR_TIMEOUT && invalid_crc == ESP_ERR_INVALID_CRC &&
+		write_nack == SGP41_ERR_WRITE_NACK && read_nack == SGP41_ERR_READ_NACK,
+		"status codes must match the C driver");
+static_assert(default_rh == SGP41_DEFAULT_RH && default_t == SGP41_DEFAULT_T &&
+		sample_uncompensated == SGP41_SAMPLE_UNCOMPENSATED &&
+		sample_recovered == SGP41_SAMPLE_RECOVERED &&
+		sample_gap == SGP41_SAMPLE_GAP && sample_warm_up == SGP41_SAMPLE_WARM_UP &&
+		sample_conditioning == SGP41_SAMPLE_CONDITIONING,
+		"default compensation must match the C driver");
+#endif
+
+static_assert(
+		execute_conditioning_cmd ==
+		sgp41_codec_descs[SGP41_CMD_CONDITIONING].opcode &&
+		measure_raw_signals_cmd == sgp41_codec_descs[SGP41_CMD_MEASURE].opcode &&
+		execute_self_test_cmd == sgp41_codec_descs[SGP41_CMD_SELF_TEST].opcode &&
+		turn_heater_off_cmd == sgp41_codec_descs[SGP41_CMD_HEATER_OFF].opcode &&
+		get_serial_number_cmd == sgp41_codec_descs[SGP41_CMD_SERIAL].opcode,
+		"commands must match the C driver");
+static_assert(ok == SGP41_CODEC_OK && invalid_crc == SGP41_CODEC_ERR_INVALID_CRC,
+		"status codes must match the codec");
+
+namespace detail {
+constexpr std::chrono::microseconds wait_time(sgp41_cmd_t cmd) {
+	return std::chrono::microseconds{sgp41_codec_descs[cmd].wait_us};
+}
+} /* namespace detail */
+
+static_assert(conditioning_time == detail::wait_time(SGP41_CMD_CONDITIONING) &&
+		measure_time == detail::wait_time(SGP41_CMD_MEASURE) &&
+		self_test_time == detail::wait_time(SGP41_CMD_SELF_TEST) &&
+		heater_off_time == detail::wait_time(SGP41_CMD_HEATER_OFF) &&
+		serial_number_time == detail::wait_time(SGP41_CMD_SERIAL),
+		"processing times must match the C driver");
+
+/* Results ------------------------------------------------------------------*/
+/**
+ * @brief Error of a failed operation, its value is the esp_err_t of the C
+ * driver so converting costs nothing
+ */
+enum class Error : status_t {
+	no_mem = sgp41::no_mem,
+	invalid_arg = sgp41::invalid_arg,
+	invalid_state = sgp41::invalid_state,
+	timeout = sgp41::timeout,
+	invalid_crc = sgp41::invalid_crc,
+	write_nack = sgp41::write_nack,
+	read_nack = sgp41::read_nack,
+};
+
+/**
+ * @brief Measurement with its timestamp, compensation and sequence number
+ */
+struct Sample {
+	std::chrono::microseconds timestamp;	/* Time the response was read */
+	uint32_t seq;													/* Per-sensor sequence number */
+	uint16_t sraw_voc;										/* VOC raw signal */
+	uint16_t sraw_nox;										/* NOx raw signal */
+	uint16_t relative_humidity;						/* Humidity compensation sent */
+	uint16_t temperature;									/* Temperature compensation sent */
+	uint8_t flags;												/* sample_* flags */
+};
+
+#ifdef SGP41_HPP_EXPECTED
+template <typename T>
+using Result = std::expected<T, Error>;
+
+namespace detail {
+inline std::unexpected<Error> failure(status_t status) {
+	return std::unexpected(static_cast<Error>(status));
+}
+} /* namespace detail */
+#endif /* SGP41_HPP_EXPECTED */
+
+/* CRC policies --------------------------------------------------------------*/
+/* Both variants are the codec of the C driver, see sgp41_codec_crc() */
+
+/**
+ * @brief CRC-8 (polynomial 0x31, init 0xFF) computed bit by bit, smallest code
+ */
+struct BitwiseCrc {
+	static constexpr bool table = false;
+
+	static constexpr uint8_t compute(const uint8_t *data, size_t count) {
+		return sgp41_codec_crc(data, count, table);
+	}
+};
+
+/**
+ * @brief CRC-8 computed through the 256 entries table of the codec
+ */
+struct TableCrc {
+	static constexpr bool table = true;
+
+	static constexpr uint8_t compute(const uint8_t *data, size_t count) {
+		return sgp41_codec_crc(data, count, table);
+	}
+};
+
+namespace detail {
+inline constexpr uint8_t crc_example[2] = {0xBE, 0xEF};
+} /* namespace detail */
+
+static_assert(BitwiseCrc::compute(detail::crc_example, 2) == 0x92 &&
+		TableCrc::compute(detail::crc_example, 2) == 0x92,
+		"CRC-8 must match the datasheet example");
+
+/* Frames --------------------------------------------------------------------*/
+namespace detail {
+/**
+ * @brief Command code followed by its argument words, each with its CRC
+ */
+struct Frame {
+	uint8_t bytes[SGP41_CODEC_FRAME_LEN_MAX];
+	size_t len;
+};
+
+/**
+ * @brief Serializes a command, usable at compile time for constant arguments
+ */
+template <typename Crc>
+constexpr Frame make_frame(sgp41_cmd_t cmd, const uint16_t *words) {
+	Frame frame{};
+	frame.len = sgp41_codec_encode(cmd, words, Crc::table, frame.bytes);
+
+	return frame;
+}
+
+inline constexpr uint16_t default_compensation[2] = {default_rh, default_t};
+
+template <typename Crc>
+inline constexpr Frame default_measure_frame =
+		make_frame<Crc>(SGP41_CMD_MEASURE, default_compensation);
+
+constexpr bool frame_equals(const Frame &frame, const uint8_t (&bytes)[8]) {
+	if (frame.len != sizeof(bytes)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < sizeof(bytes); i++) {
+		if (frame.bytes[i] != bytes[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+inline constexpr uint8_t default_measure_bytes[8] = {
+		0x26, 0x19, 0x80, 0x00, 0xA2, 0x66, 0x66, 0x93};
+} /* namespace detail */
+
+static_assert(detail::frame_equals(detail::default_measure_frame<BitwiseCrc>,
+		detail::default_measure_bytes) &&
+		detail::frame_equals(detail::default_measure_frame<TableCrc>,
+		detail::default_measure_bytes),
+		"default measure frame must match the datasheet");
+
+#ifdef SGP41_HPP_ESP_IDF
+/* ESP-IDF policies ----------------------------------------------------------*/
+/**
+ * @brief Monotonic time from esp_timer
+ */
+struct EspTimerClock {
+	static int64_t now_us() {
+		return esp_timer_get_time();
+	}
+};
+
+/**
+ * @brief Waits by spinning on the clock, as the C driver does
+ */
+struct BusyWait {
+	template <typename Clock>
+	static void wait(std::chrono::microseconds period) {
+		int64_t end = Clock::now_us() + period.count();
+
+		while (Clock::now_us() < end) {
+		}
+	}
+};
+
+/**
+ * @brief Waits by blocking the task, rounded up to whole ticks
+ */
+struct TaskDelayWait {
+	template <typename Clock>
+	static void wait(std::chrono::microseconds period) {
+		auto ms = std::chrono::ceil<std::chrono::milliseconds>(period);
+		TickType_t ticks = pdMS_TO_TICKS(ms.count());
+		vTaskDelay(ticks > 0 ? ticks : 1);
+	}
+};
+
+/**
+ * @brief Transport over a device of the I2C master driver
+ */
+struct I2cMasterTransport {
+	i2c_master_dev_handle_t dev;
+	int timeout_ms;
+
+	status_t write(const uint8_t *data, size_t len) {
+		esp_err_t ret = i2c_master_transmit(dev, data, len, timeout_ms);
+		return ret == ESP_OK ? ok : ret == ESP_ERR_TIMEOUT ? timeout : write_nack;
+	}
+
+	status_t read(uint8_t *data, size_t len) {
+		esp_err_t ret = i2c_master_receive(dev, data, len, timeout_ms);
+		return ret == ESP_OK ? ok : ret == ESP_ERR_TIMEOUT ? timeout : read_nack;
+	}
+};
+#endif /* SGP41_HPP_ESP_IDF */
+
+/* Driver --------------------------------------------------------------------*/
+/**
+ * @brief SGP41 driver whose bus, clock, wait and CRC are chosen at compile
+ * time. Commands run through the executor of the C driver, whose callbacks
+ * are a constant table of static functions, so once optimized every policy
+ * call is a direct call and the measure path inlines into the caller.
+ *
+ * Transport : status_t write(const uint8_t *, size_t), status_t read(uint8_t *,
+ *             size_t)
+ * Clock     : static int64_t now_us()
+ * Wait      : template <typename Clock> static void wait(
+ *             std::chrono::microseconds)
+ * Crc       : static constexpr bool table, CRC variant of the codec
+ */
+#ifdef SGP41_HPP_ESP_IDF
+template <typename Transport, typename Clock = EspTimerClock,
+		typename Wait = BusyWait, typename Crc = BitwiseCrc>
+#else
+template <typename Transport, typename Clock, typename Wait,
+		typename Crc = BitwiseCrc>
+#endif
+class Driver {
+public:
+	explicit Driver(Transport transport) : transport_(transport) {}
+
+	/**
+	 * @brief Starts the conditioning and returns the VOC raw signal
+	 */
+	status_t execute_conditioning(uint16_t rh, uint16_t t, uint16_t *sraw_voc) {
+		const uint16_t tx[2] = {rh, t};
+		return execute<SGP41_CMD_CONDITIONING>(tx, sraw_voc);
+	}
+
+	/**
+	 * @brief Starts/continues the VOC+NOx measurement mode
+	 */
+	status_t measure_raw_signals(uint16_t rh, uint16_t t, uint16_t *sraw_voc,
+			                         uint16_t *sraw_nox) {
+		uint16_t rx[2];
+		status_t ret;
+
+		/* The default compensation frame is built at compile time */
+		if (rh == default_rh && t == default_t) {
+			ret = transfer<SGP41_CMD_MEASURE>(detail::default_measure_frame<Crc>, rx);
+		}
+		else {
+			const uint16_t tx[2] = {rh, t};
+			ret = execute<SGP41_CMD_MEASURE>(tx, rx);
+		}
+
+		if (ret == ok) {
+			*sraw_voc = rx[0];
+			*sraw_nox = rx[1];
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Runs the built-in self test, the low nibble is zero on success
+	 */
+	status_t execute_self_test(uint16_t *test_result) {
+		return execute<SGP41_CMD_SELF_TEST>(nullptr, test_result);
+	}
+
+	/**
+	 * @brief Turns the hotplate off, the sensor enters idle mode
+	 */
+	status_t turn_heater_off() {
+		return execute<SGP41_CMD_HEATER_OFF>(nullptr, nullptr);
+	}
+
+	/**
+	 * @brief Reads the 48-bit serial number as three words
+	 */
+	status_t get_serial_number(uint16_t *serial_number) {
+		return execute<SGP41_CMD_SERIAL>(nullptr, serial_number);
+	}
+
+#ifdef SGP41_HPP_EXPECTED
+	/**
+	 * @brief Measures the raw signals and returns them as a sample
+	 */
+	Result<Sample> measure(uint16_t rh = default_rh, uint16_t t = default_t) {
+		uint16_t sraw_voc, sraw_nox;
+		status_t ret = measure_raw_signals(rh, t, &sraw_voc, &sraw_nox);
+
+		if (ret != ok) {
+			return detail::failure(ret);
+		}
+
+		return Sample{std::chrono::microseconds{Clock::now_us()}, seq_++, sraw_voc,
+				sraw_nox, rh, t,
+				(rh == default_rh && t == default_t) ? sample_uncompensated : uint8_t{0}};
+	}
+#endif /* SGP41_HPP_EXPECTED */
+
+	Transport &transport() {
+		return transport_;
+	}
+
+private:
+	/**
+	 * @brief Sends a command with its argument words, waits and reads and
+	 * checks the response words. Framing, processing time and CRC come from the
+	 * codec of the C driver
+	 */
+	template <sgp41_cmd_t Cmd>
+	status_t execute(const uint16_t *tx, uint16_t *rx) {
+		return transfer<Cmd>(detail::make_frame<Crc>(Cmd, tx), rx);
+	}
+
+	/**
+	 * @brief Sends a serialized command, waits and reads and checks the
+	 * response words with the executor of the C driver
+	 */
+	template <sgp41_cmd_t Cmd>
+	status_t transfer(const detail::Frame &frame, uint16_t *rx) {
+		static constexpr sgp41_codec_io_t io = {io_write, io_wait, io_read};
+
+		return sgp41_codec_execute(Cmd, frame.bytes, frame.len, &io, this,
+				Crc::table, rx, nullptr);
+	}
+
+	/**
+	 * @brief Executor callbacks, forwarded to the policies
+	 */
+	static int io_write(void *ctx, const uint8_t *data, size_t len) {
+		return static_cast<Driver *>(ctx)->transport_.write(data, len);
+	}
+
+	static void io_wait(void *, uint32_t period_us) {
+		Wait::template wait<Clock>(std::chrono::microseconds{period_us});
+	}
+
+	static int io_read(void *ctx, uint8_t *data, size_t len) {
+		return static_cast<Driver *>(ctx)->transport_.read(data, len);
+	}
+
+	Transport transport_;
+	uint32_t seq_ = 0;
+};
+
+#if defined(SGP41_HPP_ESP_IDF) && defined(SGP41_HPP_EXPECTED)
+/* Sensor --------------------------------------------------------------------*/
+/**
+ * @brief Move-only owner of an instance of the C driver. The instance is
+ * allocated once in open(), so it keeps its address for the metrics registry,
+ * and released with sgp41_deinit() on destruction.
+ */
+class Sensor {
+public:
+	/**
+	 * @brief Adds the sensor to a bus and initializes it
+	 */
+	static Result<Sensor> open(i2c_master_bus_handle_t bus, uint8_t address) {
+		return start([bus, address](sgp41_t *me) {
+			return sgp41_init(me, bus, address);
+		});
+	}
+
+#ifdef CONFIG_SGP41_HOOKS
+	/**
+	 * @brief Initializes a sensor reached through a custom transport, which must
+	 * outlive the sensor
+	 */
+	static Result<Sensor> open(const sgp41_transport_t *transport) {
+		return start([transport](sgp41_t *me) {
+			return sgp41_init_with_transport(me, transport);
+		});
+	}
+#endif
+
+	Sensor(Sensor &&) noexcept = default;
+	Sensor &operator=(Sensor &&) noexcept = default;
+	Sensor(const Sensor &) = delete;
+	Sensor &operator=(const Sensor &) = delete;
+
+	/**
+	 * @brief Measures the raw signals and returns them as a sample
+	 */
+	Result<Sample> measure(uint16_t rh = default_rh, uint16_t t = default_t) {
+		sgp41_sample_t sample;
+		esp_err_t ret = sgp41_measure(me_.get(), rh, t, &sample);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return to_sample(sample);
+	}
+
+#ifdef CONFIG_SGP41_LATEST
+	/**
+	 * @brief Returns the latest sample if it is at most max_age old, otherwise
+	 * measures a new one, see sgp41_get_latest()
+	 */
+	Result<Sample> latest(std::chrono::milliseconds max_age,
+			                  uint16_t rh = default_rh, uint16_t t = default_t) {
+		sgp41_sample_t sample;
+		esp_err_t ret = sgp41_get_latest(me_.get(), (uint32_t)max_age.count(), rh,
+				t, &sample);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return to_sample(sample);
+	}
+#endif /* CONFIG_SGP41_LATEST */
+
+#ifdef CONFIG_SGP41_HEALTH
+	/**
+	 * @brief Runs a due health check if it fits in the gap until the next
+	 * sample, see sgp41_health_poll(). Returns whether a check ran
+	 */
+	Result<bool> health_poll(std::chrono::milliseconds gap) {
+		bool ran;
+		esp_err_t ret = sgp41_health_poll(me_.get(), (uint32_t)gap.count(), &ran);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return ran;
+	}
+#endif /* CONFIG_SGP41_HEALTH */
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+	/**
+	 * @brief Sets when data will be needed next, in the time base of
+	 * Sample::timestamp, see sgp41_heater_schedule()
+	 */
+	Result<void> heater_schedule(std::chrono::microseconds need) {
+		esp_err_t ret = sgp41_heater_schedule(me_.get(), need.count());
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return {};
+	}
+#endif /* CONFIG_SGP41_HEATER_POWER */
+
+	/**
+	 * @brief Starts the conditioning and returns the VOC raw signal
+	 */
+	Result<uint16_t> execute_conditioning(uint16_t rh = default_rh,
+			                                  uint16_t t = default_t) {
+		uint16_t sraw_voc;
+		esp_err_t ret = sgp41_execute_conditioning(me_.get(), rh, t, &sraw_voc);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return sraw_voc;
+	}
+
+	/**
+	 * @brief Runs the built-in self test, the low nibble is zero on success
+	 */
+	Result<uint16_t> execute_self_test() {
+		uint16_t test_result;
+		esp_err_t ret = sgp41_execute_self_test(me_.get(), &test_result);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return test_result;
+	}
+
+	/**
+	 * @brief Turns the hotplate off, the sensor enters idle mode
+	 */
+	Result<void> turn_heater_off() {
+		esp_err_t ret = sgp41_turn_heater_off(me_.get());
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return {};
+	}
+
+	/**
+	 * @brief Reads the 48-bit serial number
+	 */
+	Result<uint64_t> serial_number() {
+		uint16_t words[3];
+		esp_err_t ret = sgp41_get_serial_number(me_.get(), words);
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return ((uint64_t)words[0] << 32) | ((uint64_t)words[1] << 16) | words[2];
+	}
+
+	/**
+	 * @brief Instance of the C driver, for the functions not wrapped here
+	 */
+	sgp41_t *native() const {
+		return me_.get();
+	}
+
+private:
+	struct Release {
+		void operator()(sgp41_t *me) const {
+			sgp41_deinit(me);
+			delete me;
+		}
+	};
+
+	using Handle = std::unique_ptr<sgp41_t, Release>;
+
+	explicit Sensor(Handle me) : me_(std::move(me)) {}
+
+	/**
+	 * @brief Allocates an instance and initializes it. A failed init already
+	 * released the instance, so only its memory is freed then
+	 */
+	template <typename Init>
+	static Result<Sensor> start(Init init) {
+		std::unique_ptr<sgp41_t> me{new (std::nothrow) sgp41_t{}};
+
+		if (!me) {
+			return detail::failure(ESP_ERR_NO_MEM);
+		}
+
+		esp_err_t ret = init(me.get());
+
+		if (ret != ESP_OK) {
+			return detail::failure(ret);
+		}
+
+		return Sensor{Handle{me.release()}};
+	}
+
+	static Sample to_sample(const sgp41_sample_t &sample) {
+		return Sample{std::chrono::microseconds{sample.timestamp_us}, sample.seq,
+				sample.sraw_voc, sample.sraw_nox, sample.relative_humidity,
+				sample.temperature, sample.flags};
+	}
+
+	Handle me_;
+};
+#endif /* SGP41_HPP_ESP_IDF && SGP41_HPP_EXPECTED */
+
+} /* namespace sgp41 */
+
+#endif /* SGP41_HPP_ */
+
+/***************************** END OF FILE ************************************/
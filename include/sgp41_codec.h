@@ -0,0 +1,353 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_codec.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : SGP41 command table, framing and CRC shared by the C
+  *                   driver and sgp41.hpp
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_CODEC_H_
+#define SGP41_CODEC_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Exported Macros -----------------------------------------------------------*/
+/* Everything here is header-only and free of ESP-IDF dependencies, so the C
+ * driver, sgp41.hpp and host builds share one implementation. In C++ the
+ * tables and functions are constexpr and usable at compile time */
+#ifdef __cplusplus
+#define SGP41_CODEC_TABLE								static constexpr
+#define SGP41_CODEC_FN									static constexpr
+#else
+#define SGP41_CODEC_TABLE								static const
+#define SGP41_CODEC_FN									static inline
+#endif
+
+/* The executor calls the bus through function pointers, so it is not usable
+ * at compile time */
+#define SGP41_CODEC_IO_FN								static inline
+
+/* Results of the executor, besides the errors of the I/O callbacks. Equal to
+ * ESP_OK and ESP_ERR_INVALID_CRC */
+#define SGP41_CODEC_OK									0
+#define SGP41_CODEC_ERR_INVALID_CRC			0x109
+
+/* SGP41 commands */
+#define SPG41_EXECUTE_CONDITIONING_CMD	0x2612
+#define SPG41_MESASURE_RAW_SIGNALS_CMD	0x2619
+#define SPG41_EXECUTE_SELF_TEST_CMD			0x280E
+#define SPG41_TURN_HEATER_FF_CMD				0x3615
+#define SPG41_GET_SERIAL_NUMBER_CMD			0x3682
+
+/* Largest argument list and response of any command, in 16-bit words */
+#define SGP41_COMMAND_WORDS_MAX					2
+#define SGP41_RESPONSE_WORDS_MAX				3
+
+/* Command code followed by the argument words, each with its CRC */
+#define SGP41_CODEC_FRAME_LEN_MAX				(2 + SGP41_COMMAND_WORDS_MAX * 3)
+
+/* CRC-8 of the bus words, polynomial 0x31 and init 0xFF */
+#define SGP41_CRC8_POLYNOMIAL						0x31
+#define SGP41_CRC8_INIT									0xFF
+
+/* CRC-8 of a constant word as a constant expression. The CRC is linear, each
+ * set bit adds a fixed value to the CRC of 0x0000 */
+#define SGP41_CRC8_BIT(word, bit, value)	((((word) >> (bit)) & 1) ? (value) : 0)
+#define SGP41_CRC8_WORD(word)	((uint8_t)(0x81 ^ \
+		SGP41_CRC8_BIT(word, 0, 0x31) ^ SGP41_CRC8_BIT(word, 1, 0x62) ^ \
+		SGP41_CRC8_BIT(word, 2, 0xC4) ^ SGP41_CRC8_BIT(word, 3, 0xB9) ^ \
+		SGP41_CRC8_BIT(word, 4, 0x43) ^ SGP41_CRC8_BIT(word, 5, 0x86) ^ \
+		SGP41_CRC8_BIT(word, 6, 0x3D) ^ SGP41_CRC8_BIT(word, 7, 0x7A) ^ \
+		SGP41_CRC8_BIT(word, 8, 0xF4) ^ SGP41_CRC8_BIT(word, 9, 0xD9) ^ \
+		SGP41_CRC8_BIT(word, 10, 0x83) ^ SGP41_CRC8_BIT(word, 11, 0x37) ^ \
+		SGP41_CRC8_BIT(word, 12, 0x6E) ^ SGP41_CRC8_BIT(word, 13, 0xDC) ^ \
+		SGP41_CRC8_BIT(word, 14, 0x89) ^ SGP41_CRC8_BIT(word, 15, 0x23)))
+
+/* Word serialized as sent on the bus, followed by its CRC */
+#define SGP41_CODEC_WORD(word)	(uint8_t)(((word) >> 8) & 0xFF), \
+		(uint8_t)((word) & 0xFF), SGP41_CRC8_WORD(word)
+
+/* Datasheet example */
+static_assert(SGP41_CRC8_WORD(0xBEEF) == 0x92,
+		"CRC-8 must match the datasheet example");
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef enum {
+	SGP41_CMD_CONDITIONING = 0,
+	SGP41_CMD_MEASURE,
+	SGP41_CMD_SELF_TEST,
+	SGP41_CMD_HEATER_OFF,
+	SGP41_CMD_SERIAL,
+	SGP41_CMD_MAX
+} sgp41_cmd_t;
+
+typedef struct {
+	uint16_t opcode;													/*!< Command code */
+	uint8_t tx_words;													/*!< Argument words sent after the code */
+	uint8_t rx_words;													/*!< Response words */
+	uint32_t wait_us;													/*!< Processing time before the response */
+	bool reread;															/*!< Response kept until the next command */
+} sgp41_codec_desc_t;
+
+/* reread is an assumption about the protocol: the self test result and the
+ * serial number do not change until the next command, so a response that
+ * fails its CRC is read again instead of running the command again, which
+ * takes 320 ms for the self test. Measurements are executed again, so the
+ * retried sample is a new one. A sensor that does not acknowledge the
+ * second read makes the driver execute the command again */
+
+/* Bus and wait of the executor, ctx is passed back to every callback */
+typedef struct {
+	int (*write)(void *ctx, const uint8_t *data, size_t len);	/*!< Send a command frame */
+	void (*wait)(void *ctx, uint32_t period_us);						/*!< Wait for the sensor */
+	int (*read)(void *ctx, uint8_t *data, size_t len);				/*!< Read a response */
+} sgp41_codec_io_t;
+
+/* Exported variables --------------------------------------------------------*/
+/* Command descriptors, indexed by sgp41_cmd_t */
+SGP41_CODEC_TABLE sgp41_codec_desc_t sgp41_codec_descs[SGP41_CMD_MAX] = {
+		{SPG41_EXECUTE_CONDITIONING_CMD, 2, 1, 50000, false},
+		{SPG41_MESASURE_RAW_SIGNALS_CMD, 2, 2, 50000, false},
+		{SPG41_EXECUTE_SELF_TEST_CMD, 0, 1, 320000, true},
+		{SPG41_TURN_HEATER_FF_CMD, 0, 0, 1000, false},
+		{SPG41_GET_SERIAL_NUMBER_CMD, 0, 3, 1000, true}
+};
+
+/* CRC-8 of every byte value, polynomial 0x31 */
+SGP41_CODEC_TABLE uint8_t sgp41_codec_crc8_table[256] = {
+		0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+		0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+		0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+		0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+		0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+		0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+		0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+		0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+		0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+		0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+		0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+		0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+		0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+		0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+		0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+		0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+		0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+		0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+		0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+		0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+		0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+		0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+		0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+		0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+		0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+		0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+		0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+		0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+		0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+		0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+		0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+		0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC
+};
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that computes the CRC-8 of a given data
+ *
+ * @param data  : Pointer to the data
+ * @param count : Number of bytes
+ * @param table : True to look up one byte at a time in sgp41_codec_crc8_table,
+ *                false to compute bit by bit
+ *
+ * @return CRC byte
+ */
+SGP41_CODEC_FN uint8_t sgp41_codec_crc(const uint8_t *data, size_t count,
+		                                   bool table) {
+	uint8_t crc = SGP41_CRC8_INIT;
+
+	for (size_t i = 0; i < count; i++) {
+		if (table) {
+			crc = sgp41_codec_crc8_table[crc ^ data[i]];
+			continue;
+		}
+
+		crc ^= data[i];
+
+		for (uint8_t bit = 8; bit > 0; --bit) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ SGP41_CRC8_POLYNOMIAL) :
+					(uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * @brief Function that serializes a command: its code followed by its
+ * argument words, each with its CRC
+ *
+ * @param cmd   : Command
+ * @param tx    : Pointer to the argument words, unused if the command has none
+ * @param table : CRC variant, see sgp41_codec_crc()
+ * @param frame : Pointer to a SGP41_CODEC_FRAME_LEN_MAX bytes buffer
+ *
+ * @return Length of the frame in bytes
+ */
+SGP41_CODEC_FN size_t sgp41_codec_encode(sgp41_cmd_t cmd, const uint16_t *tx,
+		                                     bool table, uint8_t *frame) {
+	const sgp41_codec_desc_t *desc = &sgp41_codec_descs[cmd];
+
+	frame[0] = (uint8_t)(desc->opcode >> 8);
+	frame[1] = (uint8_t)(desc->opcode & 0xFF);
+
+	for (uint8_t i = 0; i < desc->tx_words; i++) {
+		uint8_t *word = &frame[2 + i * 3];
+		word[0] = (uint8_t)(tx[i] >> 8);
+		word[1] = (uint8_t)(tx[i] & 0xFF);
+		word[2] = sgp41_codec_crc(word, 2, table);
+	}
+
+	return 2 + desc->tx_words * 3;
+}
+
+/**
+ * @brief Function that checks the CRC of every word of a response and
+ * extracts the words, stopping at the first mismatch
+ *
+ * @param cmd   : Command the response belongs to
+ * @param data  : Pointer to the received bytes, 3 per word
+ * @param table : CRC variant, see sgp41_codec_crc()
+ * @param rx    : Pointer where the words are stored
+ *
+ * @return Number of words decoded, the response length on success or the
+ * index of the word whose CRC did not match
+ */
+SGP41_CODEC_FN uint8_t sgp41_codec_decode(sgp41_cmd_t cmd, const uint8_t *data,
+		                                      bool table, uint16_t *rx) {
+	uint8_t words = sgp41_codec_descs[cmd].rx_words;
+
+	for (uint8_t i = 0; i < words; i++) {
+		const uint8_t *word = &data[i * 3];
+
+		if (sgp41_codec_crc(word, 2, table) != word[2]) {
+			return i;
+		}
+
+		rx[i] = (uint16_t)((word[0] << 8) | word[1]);
+	}
+
+	return words;
+}
+
+/**
+ * @brief Function that reads the response of a command and checks the CRC of
+ * every word, once the processing time has elapsed
+ *
+ * @param cmd     : Command the response belongs to
+ * @param io      : Pointer to the I/O callbacks
+ * @param ctx     : Context passed to the callbacks
+ * @param table   : CRC variant, see sgp41_codec_crc()
+ * @param rx      : Pointer where the words are stored, unused if the command
+ *                  has no response
+ * @param decoded : Pointer where the result of sgp41_codec_decode() is stored
+ *                  once the response is read, NULL to ignore it
+ *
+ * @return SGP41_CODEC_OK on success, SGP41_CODEC_ERR_INVALID_CRC on mismatch
+ * or the error of the read callback
+ */
+SGP41_CODEC_IO_FN int sgp41_codec_receive(sgp41_cmd_t cmd,
+		                                      const sgp41_codec_io_t *io,
+		                                      void *ctx, bool table, uint16_t *rx,
+		                                      uint8_t *decoded) {
+	const sgp41_codec_desc_t *desc = &sgp41_codec_descs[cmd];
+
+	if (desc->rx_words == 0) {
+		return SGP41_CODEC_OK;
+	}
+
+	uint8_t data[SGP41_RESPONSE_WORDS_MAX * 3];
+	int ret = io->read(ctx, data, (size_t)desc->rx_words * 3);
+
+	if (ret != SGP41_CODEC_OK) {
+		return ret;
+	}
+
+	uint8_t words = sgp41_codec_decode(cmd, data, table, rx);
+
+	if (decoded != NULL) {
+		*decoded = words;
+	}
+
+	return words == desc->rx_words ? SGP41_CODEC_OK :
+			SGP41_CODEC_ERR_INVALID_CRC;
+}
+
+/**
+ * @brief Function that executes a command: sends its frame, waits for the
+ * processing time of the descriptor and reads and checks the response. Both
+ * the C driver and sgp41.hpp execute commands with it
+ *
+ * @param cmd       : Command
+ * @param frame     : Pointer to the frame, see sgp41_codec_encode()
+ * @param frame_len : Length of the frame
+ * @param io        : Pointer to the I/O callbacks
+ * @param ctx       : Context passed to the callbacks
+ * @param table     : CRC variant, see sgp41_codec_crc()
+ * @param rx        : Pointer where the words are stored, unused if the command
+ *                    has no response
+ * @param decoded   : See sgp41_codec_receive()
+ *
+ * @return SGP41_CODEC_OK on success, SGP41_CODEC_ERR_INVALID_CRC on mismatch
+ * or the error of the write or read callback
+ */
+SGP41_CODEC_IO_FN int sgp41_codec_execute(sgp41_cmd_t cmd,
+		                                      const uint8_t *frame,
+		                                      size_t frame_len,
+		                                      const sgp41_codec_io_t *io,
+		                                      void *ctx, bool table, uint16_t *rx,
+		                                      uint8_t *decoded) {
+	int ret = io->write(ctx, frame, frame_len);
+
+	if (ret != SGP41_CODEC_OK) {
+		return ret;
+	}
+
+	io->wait(ctx, sgp41_codec_descs[cmd].wait_us);
+
+	return sgp41_codec_receive(cmd, io, ctx, table, rx, decoded);
+}
+
+#endif /* SGP41_CODEC_H_ */
+
+/***************************** END OF FILE ************************************/
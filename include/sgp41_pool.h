@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_pool.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Lock-free fixed-size object pools
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_POOL_H_
+#define SGP41_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sgp41.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+#define SGP41_POOL_CAPACITY_MAX					0xFFFF
+
+/* Defines a pool of count objects of type, with its storage. No init is
+ * needed, objects never used are handed out in order before recycled ones */
+#define SGP41_POOL_DEFINE(name, type, count)	\
+		_Static_assert((count) > 0 && (count) <= SGP41_POOL_CAPACITY_MAX, \
+				"pool capacity out of range"); \
+		static type name##_objects[count]; \
+		static uint16_t name##_links[count]; \
+		static sgp41_pool_t name = { \
+				.objects = (uint8_t *)name##_objects, \
+				.links = name##_links, \
+				.object_size = sizeof(type), \
+				.capacity = (count) \
+		}
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct {
+	uint8_t *objects;													/*!< Storage of capacity objects */
+	uint16_t *links;													/*!< Next free object of each object, plus 1 */
+	size_t object_size;												/*!< Size of one object */
+	uint16_t capacity;												/*!< Number of objects */
+	uint32_t head;														/*!< Free list top plus 1, tag in the high half */
+	uint32_t fresh;														/*!< Objects handed out at least once */
+	uint32_t used;														/*!< Objects allocated now */
+	uint32_t high_water;											/*!< Most objects allocated at once */
+	uint32_t failures;												/*!< Allocations that found the pool empty */
+} sgp41_pool_t;
+
+typedef struct {
+	uint16_t capacity;												/*!< Number of objects */
+	uint16_t used;														/*!< Objects allocated now */
+	uint16_t high_water;											/*!< Most objects allocated at once */
+	uint32_t failures;												/*!< Allocations that found the pool empty */
+} sgp41_pool_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function that takes an object from a pool. It is lock-free and
+ * O(1), so it can be called from any task or ISR, and never uses the heap.
+ *
+ * @param pool : Pointer to a sgp41_pool_t instance
+ *
+ * @return Pointer to the object, NULL if every object is in use
+ */
+void *sgp41_pool_alloc(sgp41_pool_t *const pool);
+
+/**
+ * @brief Function that returns an object to its pool, lock-free and O(1)
+ *
+ * @param pool   : Pointer to the sgp41_pool_t the object was taken from
+ * @param object : Pointer to the object, NULL is ignored
+ */
+void sgp41_pool_free(sgp41_pool_t *const pool, void *object);
+
+/**
+ * @brief Function that reads the usage statistics of a pool
+ *
+ * @param pool  : Pointer to a sgp41_pool_t instance
+ * @param stats : Pointer where the statistics are stored
+ */
+void sgp41_pool_get_stats(const sgp41_pool_t *const pool,
+		                      sgp41_pool_stats_t *const stats);
+
+/**
+ * @brief Function that takes a sample record from the driver pool of
+ * CONFIG_SGP41_SAMPLE_POOL_SIZE records
+ *
+ * @return Pointer to the record, NULL if the pool is exhausted
+ */
+sgp41_sample_t *sgp41_sample_alloc(void);
+
+/**
+ * @brief Function that returns a sample record to the driver pool
+ *
+ * @param sample : Pointer to a record from sgp41_sample_alloc(), NULL is
+ * ignored
+ */
+void sgp41_sample_free(sgp41_sample_t *sample);
+
+/**
+ * @brief Function that reads the usage statistics of the sample pool
+ *
+ * @param stats : Pointer where the statistics are stored
+ */
+void sgp41_sample_pool_get_stats(sgp41_pool_stats_t *const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SGP41_POOL_H_ */
+
+/***************************** END OF FILE ************************************/
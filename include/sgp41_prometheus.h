@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_prometheus.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Prometheus exporter for SGP41 metrics
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_PROMETHEUS_H_
+#define SGP41_PROMETHEUS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sgp41.h"
+
+#include "esp_http_server.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+#define SGP41_PROMETHEUS_LINE_LEN_MAX		160	/* Smallest usable render buffer */
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct {
+	uint16_t family;													/*!< Metric family being rendered */
+	bool header_done;													/*!< HELP and TYPE lines written */
+	int32_t instance;													/*!< Id of the instance being rendered */
+	uint16_t line;														/*!< Line of the instance */
+} sgp41_prometheus_cursor_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function that prepares a cursor to render a new exposition
+ *
+ * @param cursor : Pointer to a sgp41_prometheus_cursor_t instance
+ */
+void sgp41_prometheus_begin(sgp41_prometheus_cursor_t *const cursor);
+
+/**
+ * @brief Function that renders the next part of the Prometheus text exposition
+ * of every registered SGP41 instance. Only whole lines are written, and no
+ * memory is allocated, so the exposition can be streamed through a small
+ * buffer. Instances can be released between calls, the cursor then moves on
+ * to the next one.
+ *
+ * @param cursor  : Pointer to a sgp41_prometheus_cursor_t instance
+ * @param buf     : Pointer to the buffer where the text is written
+ * @param len     : Size of the buffer, at least SGP41_PROMETHEUS_LINE_LEN_MAX
+ * @param written : Pointer where the number of bytes written is stored, 0 once
+ *                  the exposition is complete
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the next line does not
+ * fit in the whole buffer
+ */
+esp_err_t sgp41_prometheus_render(sgp41_prometheus_cursor_t *const cursor,
+		                              char *buf, size_t len, size_t *written);
+
+/**
+ * @brief Function that registers a GET handler serving the exposition
+ *
+ * @param server : Handle of a running HTTP server
+ * @param uri    : URI of the endpoint, usually "/metrics"
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sgp41_prometheus_register(httpd_handle_t server, const char *uri);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SGP41_PROMETHEUS_H_ */
+
+/***************************** END OF FILE ************************************/
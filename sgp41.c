@@ -3,7 +3,7 @@
   * @file           : sgp41.c
   * @author         : Mauricio Barroso Benavides
   * @date           : Nov 29, 2023
-  * @brief          : todo: write brief
+  * @brief          : Driver for the Sensirion SGP41 VOC and NOx sensor
   ******************************************************************************
   * @attention
   *
@@ -33,77 +33,700 @@
   */
 
 /* Includes ------------------------------------------------------------------*/
+/* Messages above the configured level are compiled out */
+#define LOG_LOCAL_LEVEL								CONFIG_SGP41_LOG_LEVEL
+
 #include "sgp41.h"
+#include "sgp41_log_msgs.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 /* Private macros ------------------------------------------------------------*/
 #define NOP() asm volatile ("nop")
-#define CRC8_POLYNOMIAL 0x31
-#define CRC8_INIT 0xFF
-#define CRC8_LEN 1
+
+/* CRC variant of the codec, see sgp41_codec_crc() */
+#ifdef CONFIG_SGP41_CRC_TABLE
+#define CRC_TABLE											true
+#else
+#define CRC_TABLE											false
+#endif
+
+/* Datasheet values, the same sgp41_codec_crc() returns at runtime */
+_Static_assert(SGP41_CRC8_WORD(SGP41_DEFAULT_RH) == 0xA2 &&
+		SGP41_CRC8_WORD(SGP41_DEFAULT_T) == 0x93,
+		"CRC-8 must match the datasheet default compensation");
+
+/* Error counters, compiled out when metrics are disabled */
+#ifdef CONFIG_SGP41_METRICS
+#define COUNTER_INC(me, counter)			((me)->counters.counter++)
+#define METRIC_DESC(field, name, help)	{name, help, offsetof(sgp41_counters_t, field)}
+#else
+#define COUNTER_INC(me, counter)
+#endif
+
+/* Time from heater on until samples can be trusted */
+#ifdef CONFIG_SGP41_HEATER_AUTO_CONDITIONING
+#define HEATER_READY_MS								(CONFIG_SGP41_HEATER_WARM_UP_MS > \
+		CONFIG_SGP41_HEATER_CONDITIONING_MS ? CONFIG_SGP41_HEATER_WARM_UP_MS : \
+		CONFIG_SGP41_HEATER_CONDITIONING_MS)
+#else
+#define HEATER_READY_MS								CONFIG_SGP41_HEATER_WARM_UP_MS
+#endif
+
+/* Slot of a record number in a ring, ring sizes are powers of two */
+#define RING_SLOT(number, size)				((number) & ((size) - 1))
+
+/* Bus transactions and scheduling around a health check */
+#define HEALTH_MARGIN_US							10000
+
+/* Measurement round trips are 50 ms each, keep the benchmark short */
+#define BENCHMARK_ROUND_TRIPS_MAX			20
+
+/* Load tasks of the jitter benchmark, with static stacks in no-heap builds.
+ * The handle is kept so the benchmark deletes the task itself */
+#ifdef CONFIG_SGP41_NO_HEAP
+#define BENCHMARK_LOAD_START(task, name, index, load, priority) \
+		(((load)->tasks[index] = xTaskCreateStatic(task, name, \
+				SGP41_BENCHMARK_LOAD_STACK_SIZE, load, priority, \
+				benchmark_load_stacks[index], &benchmark_load_tasks[index])) != NULL)
+#else
+#define BENCHMARK_LOAD_START(task, name, index, load, priority) \
+		(xTaskCreate(task, name, SGP41_BENCHMARK_LOAD_STACK_SIZE, load, priority, \
+				&(load)->tasks[index]) == pdPASS)
+#endif
+
+/* Wait strategy of new instances, sgp41_set_wait() changes it */
+#ifdef CONFIG_SGP41_WAIT_TASK_DELAY
+#define WAIT_DEFAULT									SGP41_WAIT_TASK_DELAY
+#else
+#define WAIT_DEFAULT									SGP41_WAIT_BUSY
+#endif
+
+/* Time source, replaceable with sgp41_set_clock() */
+#ifdef CONFIG_SGP41_HOOKS
+#define NOW_US()											(clock_hook.now_us != NULL ? \
+		clock_hook.now_us(clock_hook.ctx) : esp_timer_get_time())
+#define TICKS_NOW()										(clock_hook.now_us != NULL ? \
+		(TickType_t)(NOW_US() / (portTICK_PERIOD_MS * 1000)) : xTaskGetTickCount())
+#else
+#define NOW_US()											esp_timer_get_time()
+#define TICKS_NOW()										xTaskGetTickCount()
+#endif
+
+/* Logging, either formatted now or recorded in binary for offline formatting */
+#ifdef CONFIG_SGP41_BINARY_LOG
+#define LOG_LEVEL_E										ESP_LOG_ERROR
+#define LOG_LEVEL_W										ESP_LOG_WARN
+#define LOG_LEVEL_I										ESP_LOG_INFO
+#define LOG_LEVEL_D										ESP_LOG_DEBUG
+#define LOG_LEVEL_V										ESP_LOG_VERBOSE
+#define LOG(level, id, ...)						do { \
+		if (LOG_LEVEL_##level <= LOG_LOCAL_LEVEL) { \
+			log_record(SGP41_LOG_ID_##id, \
+					(const uint32_t[SGP41_LOG_ARGS_MAX + 1]){0, ##__VA_ARGS__}); \
+		} \
+	} while (0)
+#else
+#define LOG(level, id, ...)						ESP_LOG##level(TAG, SGP41_MSG_##id, ##__VA_ARGS__)
+#endif
+
+/* Phase timing, compiled out when no consumer is enabled */
+#if defined(CONFIG_SGP41_LATENCY_STATS) || defined(CONFIG_SGP41_TRACE) || \
+		defined(CONFIG_SGP41_CPU_STATS)
+#define PHASE_TIMING
+#endif
+
+#ifdef PHASE_TIMING
+#define PHASE_START(ts)								int64_t ts = NOW_US()
+#define PHASE_END(me, cmd, phase, ts, status)	\
+		phase_end(me, cmd, phase, &ts, status)
+#else
+#define PHASE_START(ts)
+#define PHASE_END(me, cmd, phase, ts, status)
+#endif
 
 /* External variables --------------------------------------------------------*/
 
 /* Private typedef -----------------------------------------------------------*/
+#ifdef CONFIG_SGP41_QUEUE
+/* Request waiting in the queue, lives on the stack of the requesting task */
+typedef struct sgp41_request_s {
+	struct sgp41_request_s *next;						/* Next request, newer */
+	sgp41_cmd_t cmd;												/* Command to execute */
+	uint8_t priority;												/* Higher first */
+	UBaseType_t task_priority;							/* Priority of the requesting task */
+	uint16_t tx[SGP41_COMMAND_WORDS_MAX];		/* Argument words */
+	int64_t enqueued_us;										/* Time the request was queued */
+	esp_err_t status;												/* Result */
+	uint16_t rx[SGP41_RESPONSE_WORDS_MAX];	/* Response words */
+	sgp41_sample_t sample;									/* Result of a measurement */
+	SemaphoreHandle_t done;									/* Given once the result is stored */
+	StaticSemaphore_t done_buffer;					/* Storage of done */
+} sgp41_request_t;
+#endif /* CONFIG_SGP41_QUEUE */
+
+/* Context of the codec executor callbacks, see cmd_io */
+typedef struct {
+	sgp41_t *me;														/* Instance executing the command */
+	sgp41_cmd_t cmd;												/* Command executed */
+#ifdef PHASE_TIMING
+	int64_t ts;															/* Start of the current phase */
+#endif
+#ifdef CONFIG_SGP41_CRC_RETRY
+	int64_t ready_us;												/* Time the response was ready */
+#endif
+} cmd_io_ctx_t;
+
+#ifdef CONFIG_SGP41_BENCHMARK
+typedef enum {
+	BENCHMARK_SCHEDULE_RELATIVE = 0,				/* Delay for the rest of each period */
+	BENCHMARK_SCHEDULE_ABSOLUTE,						/* Fixed grid with xTaskDelayUntil() */
+	BENCHMARK_SCHEDULE_MAX
+} benchmark_schedule_t;
+
+typedef struct {
+	volatile bool running;									/* Cleared to stop the load tasks */
+	TaskHandle_t tasks[SGP41_BENCHMARK_LOAD_TASKS];	/* Load tasks started, or NULL */
+	i2c_master_bus_handle_t bus;						/* Bus loaded with probes */
+	uint16_t addr;													/* Address probed */
+	uint8_t duty_pct;												/* Share of the time spent probing */
+} benchmark_load_t;
+#endif /* CONFIG_SGP41_BENCHMARK */
 
 /* Private variables ---------------------------------------------------------*/
+#ifndef CONFIG_SGP41_BINARY_LOG
 static const char *TAG = "sgp41";
+#endif
+
+static uint16_t instances_count = 0;
+
+#ifdef CONFIG_SGP41_HOOKS
+static sgp41_clock_t clock_hook = {0};
+#endif
+
+/* Commands taking the default compensation, serialized at compile time */
+static const uint8_t default_frames[SGP41_CMD_MEASURE + 1][SGP41_CODEC_FRAME_LEN_MAX] = {
+		[SGP41_CMD_CONDITIONING] = {
+				(uint8_t)(SPG41_EXECUTE_CONDITIONING_CMD >> 8),
+				(uint8_t)(SPG41_EXECUTE_CONDITIONING_CMD & 0xFF),
+				SGP41_CODEC_WORD(SGP41_DEFAULT_RH), SGP41_CODEC_WORD(SGP41_DEFAULT_T)
+		},
+		[SGP41_CMD_MEASURE] = {
+				(uint8_t)(SPG41_MESASURE_RAW_SIGNALS_CMD >> 8),
+				(uint8_t)(SPG41_MESASURE_RAW_SIGNALS_CMD & 0xFF),
+				SGP41_CODEC_WORD(SGP41_DEFAULT_RH), SGP41_CODEC_WORD(SGP41_DEFAULT_T)
+		}
+};
+
+static const char *const cmd_names[SGP41_CMD_MAX] = {
+		"conditioning", "measure", "self_test", "heater_off", "serial"
+};
+
+static const char *const phase_names[SGP41_PHASE_MAX] = {
+		"write", "wait", "read", "crc", "queue"
+};
+
+#ifdef CONFIG_SGP41_BENCHMARK
+static const char *const wait_names[SGP41_WAIT_MAX] = {
+		"busy", "task_delay"
+};
+#endif
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+_Static_assert((CONFIG_SGP41_BINARY_LOG_RING_SIZE &
+		(CONFIG_SGP41_BINARY_LOG_RING_SIZE - 1)) == 0,
+		"the binary log ring size must be a power of two");
+
+static sgp41_log_record_t log_ring[CONFIG_SGP41_BINARY_LOG_RING_SIZE];
+static uint32_t log_stamps[CONFIG_SGP41_BINARY_LOG_RING_SIZE];
+static uint32_t log_head = 0;
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+#ifdef CONFIG_SGP41_TRACE
+_Static_assert((CONFIG_SGP41_TRACE_RING_SIZE &
+		(CONFIG_SGP41_TRACE_RING_SIZE - 1)) == 0,
+		"the trace ring size must be a power of two");
+
+static sgp41_trace_event_t trace_ring[CONFIG_SGP41_TRACE_RING_SIZE];
+static uint32_t trace_stamps[CONFIG_SGP41_TRACE_RING_SIZE];
+static uint32_t trace_head = 0;
+#endif /* CONFIG_SGP41_TRACE */
+
+#ifdef CONFIG_SGP41_METRICS
+static const sgp41_metric_desc_t metric_descs[] = {
+		METRIC_DESC(crc_errors[0], "crc_errors_word0", "CRC mismatches on response word 0"),
+		METRIC_DESC(crc_errors[1], "crc_errors_word1", "CRC mismatches on response word 1"),
+		METRIC_DESC(crc_errors[2], "crc_errors_word2", "CRC mismatches on response word 2"),
+		METRIC_DESC(write_nacks, "write_nacks", "Command writes not acknowledged"),
+		METRIC_DESC(read_nacks, "read_nacks", "Response reads not acknowledged"),
+		METRIC_DESC(timeouts, "timeouts", "I2C transactions timed out"),
+		METRIC_DESC(self_test_failures, "self_test_failures", "Self tests reporting a failed pixel"),
+		METRIC_DESC(voc_pixel_failures, "voc_pixel_failures", "Self tests reporting a failed VOC pixel"),
+		METRIC_DESC(nox_pixel_failures, "nox_pixel_failures", "Self tests reporting a failed NOx pixel"),
+		METRIC_DESC(crc_retries, "crc_retries", "Responses read again after a CRC mismatch"),
+		METRIC_DESC(crc_recoveries, "crc_recoveries", "Commands that succeeded after retrying"),
+		METRIC_DESC(health_skips, "health_skips", "Sample slots given to a health check"),
+};
+
+static sgp41_t *instances = NULL;
+static uint32_t instances_readers = 0;
+static portMUX_TYPE instances_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+/* Set while a benchmark runs, they share the load tasks and skew each other */
+static bool benchmark_running = false;
+#endif
+
+#if defined(CONFIG_SGP41_BENCHMARK) && defined(CONFIG_SGP41_NO_HEAP)
+static StackType_t benchmark_load_stacks[SGP41_BENCHMARK_LOAD_TASKS]
+		[SGP41_BENCHMARK_LOAD_STACK_SIZE];
+static StaticTask_t benchmark_load_tasks[SGP41_BENCHMARK_LOAD_TASKS];
+
+_Static_assert(sizeof(benchmark_load_stacks) + sizeof(benchmark_load_tasks) ==
+		SGP41_BENCHMARK_BYTES, "SGP41_BENCHMARK_BYTES must match the load tasks");
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that executes a command: sends its code and argument words,
+ * waits for the sensor and reads and checks the response words
+ *
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command to execute
+ * @param tx  : Pointer to the argument words, NULL if the command has none
+ * @param rx  : Pointer where the response words are stored, NULL if the
+ *              command has none
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t cmd_execute(sgp41_t *const me, sgp41_cmd_t cmd,
+		                         const uint16_t *tx, uint16_t *rx);
+
+/**
+ * @brief Function that executes a command once through the codec executor,
+ * without retries
+ *
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command to execute
+ * @param tx  : Pointer to the argument words, NULL if the command has none
+ * @param rx  : Pointer where the response words are stored, NULL if the
+ *              command has none
+ * @param ctx : Pointer to the executor context, initialized here
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t cmd_transfer(sgp41_t *const me, sgp41_cmd_t cmd,
+		                          const uint16_t *tx, uint16_t *rx,
+															cmd_io_ctx_t *ctx);
+
+/**
+ * @brief Function that returns the frame of a command. The default
+ * compensation is already serialized, other arguments are serialized in a
+ * given buffer
+ *
+ * @param cmd       : Command to send
+ * @param tx        : Pointer to the argument words, NULL if the command has
+ *                    none
+ * @param buffer    : Pointer to a SGP41_CODEC_FRAME_LEN_MAX bytes buffer
+ * @param frame_len : Pointer where the length of the frame is stored
+ *
+ * @return Pointer to the frame
+ */
+static const uint8_t *cmd_frame(sgp41_cmd_t cmd, const uint16_t *tx,
+		                            uint8_t *buffer, size_t *frame_len);
+
+/**
+ * @brief Function that sends the code and argument words of a command
+ *
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command to send
+ * @param tx  : Pointer to the argument words, NULL if the command has none
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t cmd_send(sgp41_t *const me, sgp41_cmd_t cmd,
+		                      const uint16_t *tx);
+
+/**
+ * @brief Function that reads and checks the response words of a command sent
+ * with cmd_send(), once the processing time has elapsed
+ *
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command sent
+ * @param rx  : Pointer where the response words are stored, NULL if the
+ *              command has none
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t cmd_receive(sgp41_t *const me, sgp41_cmd_t cmd, uint16_t *rx);
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+/**
+ * @brief Function that retries a command whose response failed the CRC check,
+ * while the retries fit in its time budget. The response is read again if the
+ * sensor keeps it, otherwise the command is executed again. The number of
+ * retries is left in me->retries.
+ *
+ * @param me          : Pointer to a sgp41_t instance
+ * @param cmd         : Command executed
+ * @param tx          : Pointer to the argument words, NULL if the command has
+ *                      none
+ * @param rx          : Pointer where the response words are stored
+ * @param ret         : Result of the first attempt
+ * @param deadline_us : Time by which the last retry must be finished
+ *
+ * @return Result of the last attempt
+ */
+static esp_err_t cmd_retry(sgp41_t *const me, sgp41_cmd_t cmd,
+		                       const uint16_t *tx, uint16_t *rx, esp_err_t ret,
+													 int64_t deadline_us);
+#endif /* CONFIG_SGP41_CRC_RETRY */
+
+#ifdef CONFIG_SGP41_HEATER
+/**
+ * @brief Function that updates the heater state after a command was written
+ *
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command written
+ */
+static void heater_track(sgp41_t *const me, sgp41_cmd_t cmd);
+
+/**
+ * @brief Function that returns the command that measures an instance: the
+ * conditioning while the NOx pixel needs it, the measurement otherwise
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return SGP41_CMD_CONDITIONING or SGP41_CMD_MEASURE
+ */
+static sgp41_cmd_t heater_measure_cmd(sgp41_t *const me);
+#endif /* CONFIG_SGP41_HEATER */
+
+/**
+ * @brief Function that fills a sample record from a measurement result and
+ * keeps it as the latest sample of the instance
+ *
+ * @param me           : Pointer to a sgp41_t instance
+ * @param compensation : Pointer to the humidity and temperature words sent
+ * @param rx           : Pointer to the VOC and NOx words received
+ * @param status       : Result of the measurement
+ * @param sample       : Pointer where the record is stored
+ */
+static void sample_fill(sgp41_t *const me, const uint16_t *compensation,
+		                    const uint16_t *rx, esp_err_t status,
+												sgp41_sample_t *sample);
+
+/**
+ * @brief Function that clears the state of an instance before it is started
+ *
+ * @param me : Pointer to a sgp41_t instance
+ */
+static void instance_reset(sgp41_t *const me);
+
+/**
+ * @brief Function that runs the self test, reads the serial number and
+ * registers an instance
+ *
+ * @param me : Pointer to a sgp41_t instance
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t instance_start(sgp41_t *const me);
+
 /**
  * @brief Function that implements the default I2C read transaction
  *
- * @param reg_addr : Register address to be read
- * @param reg_data : Pointer to the data to be read from reg_addr
- * @param data_len : Length of the data transfer
- * @param intf     : Pointer to the interface descriptor
+ * @param data     : Pointer where the response is stored
+ * @param data_len : Length of the response
+ * @param intf     : Pointer to the sgp41_t instance
  *
- * @return 0 if successful, non-zero otherwise
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT or SGP41_ERR_READ_NACK otherwise
  */
-static int8_t i2c_read(uint16_t reg_addr, uint8_t *reg_data, uint32_t data_len,
-		                   void *intf);
+static esp_err_t i2c_read(uint8_t *data, uint32_t data_len, void *intf);
 /**
  * @brief Function that implements the default I2C write transaction
  *
- * @param reg_addr : Register address to be written
- * @param reg_data : Pointer to the data to be written to reg_addr
- * @param data_len : Length of the data transfer
- * @param intf     : Pointer to the interface descriptor
+ * @param frame     : Pointer to the command frame, see sgp41_codec_encode()
+ * @param frame_len : Length of the frame
+ * @param intf      : Pointer to the sgp41_t instance
+ *
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT or SGP41_ERR_WRITE_NACK otherwise
+ */
+static esp_err_t i2c_write(const uint8_t *frame, uint32_t frame_len,
+		                       void *intf);
+
+/**
+ * @brief Function that starts the executor context of a command
+ *
+ * @param ctx : Pointer to the context
+ * @param me  : Pointer to a sgp41_t instance
+ * @param cmd : Command executed
+ */
+static void io_start(cmd_io_ctx_t *ctx, sgp41_t *const me, sgp41_cmd_t cmd);
+
+/**
+ * @brief Executor callback that writes a command frame, books the write phase
+ * and tracks the heater state
+ *
+ * @param ctx      : Pointer to the cmd_io_ctx_t of the command
+ * @param data     : Pointer to the frame
+ * @param data_len : Length of the frame
+ *
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT or SGP41_ERR_WRITE_NACK otherwise
+ */
+static int io_write(void *ctx, const uint8_t *data, size_t data_len);
+
+/**
+ * @brief Executor callback that waits with the wait strategy of the instance
+ * and books the wait phase
+ *
+ * @param ctx       : Pointer to the cmd_io_ctx_t of the command
+ * @param period_us : Processing time of the command
+ */
+static void io_wait(void *ctx, uint32_t period_us);
+
+/**
+ * @brief Executor callback that reads a response and books the read phase
+ *
+ * @param ctx      : Pointer to the cmd_io_ctx_t of the command
+ * @param data     : Pointer where the response is stored
+ * @param data_len : Length of the response
+ *
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT or SGP41_ERR_READ_NACK otherwise
+ */
+static int io_read(void *ctx, uint8_t *data, size_t data_len);
+
+/**
+ * @brief Function that books the CRC check of a response returned by the
+ * executor and counts the mismatches per word
+ *
+ * @param ctx     : Pointer to the executor context
+ * @param ret     : Result of the executor
+ * @param decoded : Words decoded, see sgp41_codec_receive()
+ *
+ * @return ret
+ */
+static esp_err_t io_check(cmd_io_ctx_t *ctx, esp_err_t ret, uint8_t decoded);
+
+/**
+ * @brief Function that implements a micro seconds delay with the wait
+ * strategy of an instance
+ *
+ * @param me        : Pointer to the sgp41_t instance waiting
+ * @param period_us : Time in us to delay
+ */
+static void delay_us(const sgp41_t *const me, uint32_t period_us);
+
+/**
+ * @brief Function that blocks the task until a number of tick interrupts
+ * have passed, on the driver clock when it was replaced
+ *
+ * @param ticks : Number of ticks, 0 returns at once
+ */
+static void delay_ticks(TickType_t ticks);
+
+#ifdef CONFIG_SGP41_METRICS
+/**
+ * @brief Function that adds an instance to the metrics registry
+ *
+ * @param me : Pointer to a sgp41_t instance
+ */
+static void metrics_register(sgp41_t *const me);
+
+/**
+ * @brief Function that removes an instance from the metrics registry
+ *
+ * @param me : Pointer to a sgp41_t instance
+ */
+static void metrics_unregister(sgp41_t *const me);
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+/**
+ * @brief Function that records a log message in the binary log ring
+ *
+ * @param id   : Message ID, see sgp41_log_msgs.h
+ * @param args : Pointer to a placeholder followed by SGP41_LOG_ARGS_MAX
+ *               arguments
+ */
+static void log_record(uint16_t id, const uint32_t *args);
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+#if defined(CONFIG_SGP41_BINARY_LOG) || defined(CONFIG_SGP41_TRACE)
+/**
+ * @brief Function that claims the next record of a ring and stamps its slot
+ * as being written, so readers skip it until ring_publish()
+ *
+ * @param head   : Pointer to the number of records ever claimed
+ * @param stamps : Pointer to the stamps of the ring slots
+ * @param size   : Number of slots, a power of two
+ *
+ * @return Number of the claimed record
+ */
+static uint32_t ring_claim(uint32_t *head, uint32_t *stamps, uint32_t size);
+
+/**
+ * @brief Function that stamps a written record as readable
+ *
+ * @param stamps : Pointer to the stamps of the ring slots
+ * @param number : Number of the record
+ * @param size   : Number of slots, a power of two
+ */
+static void ring_publish(uint32_t *stamps, uint32_t number, uint32_t size);
+
+/**
+ * @brief Function that copies a record unless it was overwritten or is being
+ * written
+ *
+ * @param stamps : Pointer to the stamps of the ring slots
+ * @param number : Number of the record
+ * @param size   : Number of slots, a power of two
+ * @param dst    : Pointer where the record is copied
+ * @param src    : Pointer to the slot of the record
+ * @param len    : Size of a record
+ *
+ * @return True if dst holds the whole record
+ */
+static bool ring_copy(const uint32_t *stamps, uint32_t number, uint32_t size,
+		                  void *dst, const void *src, size_t len);
+#endif /* CONFIG_SGP41_BINARY_LOG || CONFIG_SGP41_TRACE */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+/**
+ * @brief Function that orders two uint32_t values for qsort()
+ *
+ * @param a : Pointer to the first value
+ * @param b : Pointer to the second value
+ *
+ * @return Negative, zero or positive as a is less, equal or greater than b
+ */
+static int benchmark_compare_u32(const void *a, const void *b);
+
+/**
+ * @brief Function that marks a benchmark as running
+ *
+ * @return True on success, false if another benchmark is running
+ */
+static bool benchmark_begin(void);
+
+/**
+ * @brief Function that marks the running benchmark as finished
+ */
+static void benchmark_end(void);
+
+/**
+ * @brief Function that stops the load tasks and deletes them, so their
+ * stacks and control blocks are free once it returns
+ *
+ * @param load : Pointer to the benchmark_load_t shared with the load tasks
+ */
+static void benchmark_load_stop(benchmark_load_t *load);
+
+/**
+ * @brief Function that loads the CPU about half of the time
+ *
+ * @param arg : Pointer to the benchmark_load_t shared with the benchmark
+ */
+static void benchmark_cpu_load_task(void *arg);
+
+/**
+ * @brief Function that keeps the bus busy with probes for a share of the time
+ *
+ * @param arg : Pointer to the benchmark_load_t shared with the benchmark
+ */
+static void benchmark_bus_load_task(void *arg);
+
+/**
+ * @brief Function that waits for the next sample of the jitter benchmark,
+ * with the driver clock when it was replaced and FreeRTOS otherwise
  *
- * @return 0 if successful, non-zero otherwise
+ * @param schedule   : BENCHMARK_SCHEDULE_RELATIVE or _ABSOLUTE
+ * @param last_wake  : Pointer to the tick of the previous wake up
+ * @param start_tick : Tick the sample started on
+ * @param period_ms  : Sampling period
  */
-static int8_t i2c_write(uint16_t reg_addr, const uint8_t *reg_data,
-		                    uint32_t data_len, void *intf);
+static void benchmark_pace(uint8_t schedule, TickType_t *last_wake,
+		                       TickType_t start_tick, uint32_t period_ms);
+
+#ifdef CONFIG_SGP41_METRICS
 /**
- * @brief Function that implements a micro seconds delay
+ * @brief Function that returns how much a counter grew since the stress run
+ * started
  *
- * @param period_us: Time in us to delay
+ * @param me    : Pointer to a sgp41_t instance
+ * @param index : Counter index, see sgp41_metrics_get_descs()
+ *
+ * @return Counter value minus its value when the run started
  */
-static void delay_us(uint32_t period_us);
+static uint32_t benchmark_counter_delta(const sgp41_t *const me, size_t index);
+#endif
 
 /**
- * @brief Function that generates a CRC byte for a given data
+ * @brief Function that prints one benchmark result as a JSON line
  *
- * @param data  :
- * @param count :
+ * @param stream     : Stream where the result is printed
+ * @param name       : Name of the benchmark
+ * @param iterations : Number of timed operations
+ * @param elapsed_us : Total time of all the operations in us
+ */
+static void benchmark_report(FILE *stream, const char *name,
+		                         uint32_t iterations, int64_t elapsed_us);
+#endif /* CONFIG_SGP41_BENCHMARK */
+
+#ifdef CONFIG_SGP41_QUEUE
+/**
+ * @brief Function that queues a request and waits for its result, serving
+ * the queue if no other task does
  *
- * @return CRC byte
+ * @param me      : Pointer to a sgp41_t instance
+ * @param request : Pointer to the request, cmd, priority and tx set
  */
-static uint8_t generate_crc(const uint8_t *data, uint16_t count);
+static void queue_submit(sgp41_t *const me, sgp41_request_t *request);
 
 /**
- * @brief Function that checks the CRC for the received data
+ * @brief Function that executes the pending requests until the queue is
+ * empty, merging the ones for the same command
  *
- * @param data     :
- * @param count    :
- * @param checksum :
+ * @param me : Pointer to a sgp41_t instance
+ */
+static void queue_serve(sgp41_t *const me);
+#endif /* CONFIG_SGP41_QUEUE */
+
+#ifdef PHASE_TIMING
+/**
+ * @brief Function that records the duration of a command phase
  *
- * @return False on failure or True on success
+ * @param me     : Pointer to a sgp41_t instance
+ * @param cmd    : Command being executed
+ * @param phase  : Phase that just ended
+ * @param ts     : Pointer to the phase start timestamp, updated to now
+ * @param status : ESP_OK, or the error that ended the phase
  */
-static bool check_crc(const uint8_t *data, uint16_t count, uint8_t checksum);
+static void phase_end(sgp41_t *const me, sgp41_cmd_t cmd, sgp41_phase_t phase,
+		                  int64_t *ts, esp_err_t status);
+#endif /* PHASE_TIMING */
+
+/* Bus and wait of the codec executor, defined after its callbacks are
+ * declared. The executor returns the esp_err_t of the callbacks as is */
+static_assert(SGP41_CODEC_OK == ESP_OK &&
+		SGP41_CODEC_ERR_INVALID_CRC == ESP_ERR_INVALID_CRC,
+		"codec results must match esp_err_t");
+
+static const sgp41_codec_io_t cmd_io = {
+		.write = io_write,
+		.wait = io_wait,
+		.read = io_read
+};
 
 /* Exported functions definitions --------------------------------------------*/
 /**
@@ -112,273 +735,1978 @@ static bool check_crc(const uint8_t *data, uint16_t count, uint8_t checksum);
 esp_err_t sgp41_init(sgp41_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
 		uint8_t dev_addr) {
 	/* Print initializing message */
-	ESP_LOGI(TAG, "Initializing instance...");
+	LOG(I, INIT);
 
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
+	instance_reset(me);
+
 	/* Add device to I2C bus */
 	i2c_device_config_t i2c_dev_conf = {
 			.scl_speed_hz = 400000,
 			.device_address = dev_addr
 	};
 
-	if (i2c_master_bus_add_device(i2c_bus_handle, &i2c_dev_conf, &me->i2c_dev) != ESP_OK) {
-		ESP_LOGE(TAG, "Failed to add device to I2C bus");
-		return ret;
-	}
+	ret = i2c_master_bus_add_device(i2c_bus_handle, &i2c_dev_conf, &me->i2c_dev);
 
-	/* Execute selff test */
-	ESP_LOGI(TAG, "Executing self test...");
-	uint16_t test_result;
-	sgp41_execute_self_test(me, &test_result);
+	if (ret != ESP_OK) {
+		LOG(E, ADD_DEVICE_FAIL, ret);
+		me->i2c_dev = NULL;
 
-	if (test_result != 0xD400) {
-		ESP_LOGE(TAG, "Self test failed with error: 0x%X", test_result);
-	}
-	else {
-		ESP_LOGI(TAG, "Self test executed successfully");
+		/* Release the locks */
+		sgp41_deinit(me);
+		return ret;
 	}
 
-	/* Get and print serial number */
-	uint16_t serial_number[3];
-	sgp41_get_serial_number(me, serial_number);
-	ESP_LOGI(TAG, "Serial number: 0X%04X%04X%04X\n",
-			serial_number[0], serial_number[1], serial_number[2]);
+	ret = instance_start(me);
 
-	/* Print successful initialization message */
-	ESP_LOGI(TAG, "Instance initialized successfully");
+	if (ret != ESP_OK) {
+		/* Remove the device and release the locks */
+		sgp41_deinit(me);
+	}
 
-	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function that starts the conditioning, i.e., the VOC pixel will be
- * operated at the same temperature as it is by calling the sgp41_measure_raw
- * command while the NOx pixel will be operated at a different temperature for
- * conditioning. Function that returns only the measured raw signal of the VOC
- * pixel SRAW_VOC as 2 bytes (+ 1 CRC byte).
+ * @brief Function that releases a SGP41 instance
  */
-esp_err_t sgp41_execute_conditioning(sgp41_t *const me, uint16_t default_rh,
-		                                 uint16_t default_t, uint16_t *sraw_voc) {
+esp_err_t sgp41_deinit(sgp41_t *const me) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Conditioning and get signal raw VOC */
-	uint8_t data_tx[6] = {(uint8_t)((default_rh >> 8) & 0xFF),
-			(uint8_t)(default_rh & 0xFF),
-			generate_crc(&data_tx[0], 2),
-			(uint8_t)((default_t >> 8) & 0xFF),
-			(uint8_t)(default_t & 0xFF),
-			generate_crc(&data_tx[3], 2)};
+#ifdef CONFIG_SGP41_METRICS
+	metrics_unregister(me);
+#endif
 
-	if (i2c_write(SPG41_EXECUTE_CONDITIONING_CMD, data_tx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	/* A failed init already released the instance, a second call finds the
+	 * locks gone */
+#ifdef CONFIG_SGP41_LATEST
+	if (me->latest_lock != NULL) {
+		vSemaphoreDelete(me->latest_lock);
+		me->latest_lock = NULL;
 	}
+#endif
 
-	delay_us(50 * 1000); /* Wait for 50 ms */
-
-	uint8_t data_rx[3] = {0};
-
-	if (i2c_read(0, data_rx, 3, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+#ifdef CONFIG_SGP41_QUEUE
+	if (me->queue_owner != NULL) {
+		vSemaphoreDelete(me->queue_owner);
+		me->queue_owner = NULL;
 	}
+#endif
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 3; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	/* Instances with a custom transport have no device */
+	if (me->i2c_dev != NULL) {
+		ret = i2c_master_bus_rm_device(me->i2c_dev);
+		me->i2c_dev = NULL;
 	}
 
-	*sraw_voc = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-
-	/* Return ESP_OK */
 	return ret;
 }
 
+#ifdef CONFIG_SGP41_HOOKS
 /**
- * @brief Function that starts/continues the VOC+NOx
- * measurement mode.
+ * @brief Function that initializes a SGP41 instance that talks through a
+ * custom transport instead of the I2C master driver
  */
-esp_err_t sgp41_measure_raw_signals(sgp41_t *const me, uint16_t relative_humidity,
-		                                uint16_t temperature, uint16_t *sraw_voc,
-																		uint16_t *sraw_nox) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
-
-	/* Get VOC and NOx raw signals */
-	uint8_t data_tx[6] = {(uint8_t)((relative_humidity >> 8) & 0xFF),
-			(uint8_t)(relative_humidity & 0xFF),
-			generate_crc(&data_tx[0], 2),
-			(uint8_t)((temperature >> 8) & 0xFF),
-			(uint8_t)(temperature & 0xFF),
-			generate_crc(&data_tx[3], 2)};
-
-	if (i2c_write(SPG41_MESASURE_RAW_SIGNALS_CMD, data_tx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+esp_err_t sgp41_init_with_transport(sgp41_t *const me,
+		                                const sgp41_transport_t *transport) {
+	if (me == NULL || transport == NULL || transport->write == NULL ||
+			transport->read == NULL) {
+		return ESP_ERR_INVALID_ARG;
 	}
 
-	delay_us(50 * 1000); /* Wait for 50 ms */
+	/* Print initializing message */
+	LOG(I, INIT);
 
-	uint8_t data_rx[6] = {0};
+	instance_reset(me);
+	me->i2c_dev = NULL;
+	me->transport = transport;
 
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+	esp_err_t ret = instance_start(me);
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	if (ret != ESP_OK) {
+		/* Release the locks */
+		sgp41_deinit(me);
 	}
 
-	*sraw_voc = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*sraw_nox = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
-
-	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function that triggers the built-in self-test checking for integrity
- * of both hotplate and MOX material and returns the result of this test as 2
- * bytes.
+ * @brief Function that replaces the time source and the waits of the driver
  */
-esp_err_t sgp41_execute_self_test(sgp41_t *const me, uint16_t *test_result) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
-
-	/* Execute a self test */
-	if (i2c_write(SPG41_EXECUTE_SELF_TEST_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+esp_err_t sgp41_set_clock(const sgp41_clock_t *clock) {
+	if (clock == NULL) {
+		clock_hook = (sgp41_clock_t) {0};
+		return ESP_OK;
 	}
 
-	delay_us(320 * 1000); /* Wait for 320 ms */
-
-	uint8_t data_rx[3] = {0};
-
-	if (i2c_read(0, data_rx, 3, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
-
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 3; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	if (clock->now_us == NULL || clock->wait_us == NULL) {
+		return ESP_ERR_INVALID_ARG;
 	}
 
-	*test_result = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
+	clock_hook = *clock;
 
 	/* Return ESP_OK */
-	return ret;
+	return ESP_OK;
 }
+#endif /* CONFIG_SGP41_HOOKS */
 
 /**
- * @brief Function that turns the hotplate off and stops the
- * measurement. Subsequently, the sensor enters the idle mode.
+ * @brief Function that selects how an instance waits for the sensor
  */
-esp_err_t sgp41_turn_heater_off(sgp41_t *const me) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
-
-	/* Turn off the heater */
-	if (i2c_write(SPG41_TURN_HEATER_FF_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+esp_err_t sgp41_set_wait(sgp41_t *const me, sgp41_wait_t wait) {
+	if (me == NULL || wait >= SGP41_WAIT_MAX) {
+		return ESP_ERR_INVALID_ARG;
 	}
 
-	delay_us(1 * 1000); /* Wait for 1 ms */
+	me->wait = wait;
 
 	/* Return ESP_OK */
-	return ret;
+	return ESP_OK;
 }
 
 /**
- * @brief Function that provides the decimal serial number of the SGP41 chip by
- * returning 3x2 bytes.
+ * @brief Function that starts the conditioning, i.e., the VOC pixel will be
+ * operated at the same temperature as it is by calling the sgp41_measure_raw
+ * command while the NOx pixel will be operated at a different temperature for
+ * conditioning. Function that returns only the measured raw signal of the VOC
+ * pixel SRAW_VOC as 2 bytes (+ 1 CRC byte).
  */
-esp_err_t sgp41_get_serial_number(sgp41_t *const me, uint16_t *serial_number) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
+esp_err_t sgp41_execute_conditioning(sgp41_t *const me, uint16_t default_rh,
+		                                 uint16_t default_t, uint16_t *sraw_voc) {
+	/* Conditioning and get signal raw VOC */
+	const uint16_t tx[2] = {default_rh, default_t};
+	esp_err_t ret = cmd_execute(me, SGP41_CMD_CONDITIONING, tx, sraw_voc);
 
-	/* Get the serial number */
-	if (i2c_write(SPG41_GET_SERIAL_NUMBER_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	delay_us(1 * 1000); /* Wait for 1 ms */
+#ifdef CONFIG_SGP41_METRICS
+	/* Keep the latest sample for exporters, NOx is not measured */
+	me->sraw_voc = *sraw_voc;
+	me->sample_us = NOW_US();
+#endif
 
-	uint8_t data_rx[9] = {0};
+	/* Return ESP_OK */
+	return ret;
+}
 
-	if (i2c_read(0, data_rx, 9, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+/**
+ * @brief Function that starts/continues the VOC+NOx
+ * measurement mode.
+ */
+esp_err_t sgp41_measure_raw_signals(sgp41_t *const me, uint16_t relative_humidity,
+		                                uint16_t temperature, uint16_t *sraw_voc,
+																		uint16_t *sraw_nox) {
+	/* Get VOC and NOx raw signals */
+	sgp41_sample_t sample;
+	esp_err_t ret = sgp41_measure(me, relative_humidity, temperature, &sample);
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 9; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	serial_number[0] = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	serial_number[1] = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
-	serial_number[2] = (uint16_t)((data_rx[6] << 8) | (data_rx[7]));
+	*sraw_voc = sample.sraw_voc;
+	*sraw_nox = sample.sraw_nox;
 
 	/* Return ESP_OK */
 	return ret;
 }
 
-/* Private function definitions ----------------------------------------------*/
 /**
- * @brief Function that implements the default I2C read transaction
+ * @brief Function that measures the VOC and NOx raw signals and returns them
+ * as a sample record
  */
-static int8_t i2c_read(uint16_t reg_addr, uint8_t *reg_data, uint32_t data_len,
-		                   void *intf) {
-	i2c_master_dev_handle_t i2c_dev = (i2c_master_dev_handle_t)intf;
+esp_err_t sgp41_measure(sgp41_t *const me, uint16_t relative_humidity,
+		                    uint16_t temperature, sgp41_sample_t *sample) {
+	const uint16_t tx[2] = {relative_humidity, temperature};
+	uint16_t rx[2] = {0};	/* Conditioning only returns rx[0] */
+	sgp41_cmd_t cmd = SGP41_CMD_MEASURE;
 
-	if (i2c_master_receive(i2c_dev, reg_data, data_len, -1) != ESP_OK) {
-		return -1;
-	}
+#ifdef CONFIG_SGP41_HEATER
+	cmd = heater_measure_cmd(me);
+#endif
+
+	esp_err_t ret = cmd_execute(me, cmd, tx, rx);
+
+	sample_fill(me, tx, rx, ret, sample);
 
-	return 0;
+	return ret;
 }
 
 /**
- * @brief Function that implements the default I2C write transaction
+ * @brief Function that measures several instances at once: every command is
+ * written, the processing time is waited once and every response is read
  */
-static int8_t i2c_write(uint16_t reg_addr, const uint8_t *reg_data,
-		                    uint32_t data_len, void *intf) {
-	i2c_master_dev_handle_t i2c_dev = (i2c_master_dev_handle_t)intf;
+esp_err_t sgp41_measure_batch(sgp41_t *const *instances, size_t count,
+		                          uint16_t relative_humidity, uint16_t temperature,
+															sgp41_sample_t *samples) {
+	if (instances == NULL || samples == NULL || count == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	uint8_t buffer[SGP41_I2C_BUFFER_LEN_MAX] = {0};
-	uint8_t addr_len = sizeof(reg_addr);
+	const uint16_t tx[2] = {relative_humidity, temperature};
+	esp_err_t ret = ESP_OK;
 
-	/* Copy the register address to buffer */
-	for (uint8_t i = 0; i < addr_len; i++) {
-		buffer[i] = (reg_addr & (0xFF << ((addr_len - 1 - i) * 8))) >> ((addr_len - 1 - i) * 8);
-	}
+	/* Start every measurement, the status is kept in the sample until read */
+	sgp41_cmd_t last_cmd = SGP41_CMD_MEASURE;
 
-	/* Copy the data to buffer */
-	for (uint8_t i = 0; i < data_len; i++) {
-		buffer[i + addr_len] = reg_data[i];
-	}
+	for (size_t i = 0; i < count; i++) {
+#ifdef CONFIG_SGP41_HEATER
+		last_cmd = heater_measure_cmd(instances[i]);
+#endif
 
-	/* Transmit buffer */
-	if (i2c_master_transmit(i2c_dev, buffer, addr_len + data_len, -1) != ESP_OK) {
-		return -1;
+		samples[i].status = cmd_send(instances[i], last_cmd, tx);
 	}
 
-	return 0;
-}
+	/* The last command written is the last one ready. Conditioning takes as
+	 * long as a measurement. The wait is shared, so it is booked once, to the
+	 * instance it was timed for */
+	PHASE_START(ts);
+	delay_us(instances[count - 1], sgp41_codec_descs[SGP41_CMD_MEASURE].wait_us);
+	PHASE_END(instances[count - 1], last_cmd, SGP41_PHASE_WAIT, ts, ESP_OK);
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+	/* Retries of every instance share the budget of the batch */
+	int64_t deadline_us = NOW_US() + CONFIG_SGP41_CRC_RETRY_BUDGET_MS * 1000LL;
+#endif
+
+	for (size_t i = 0; i < count; i++) {
+		uint16_t rx[2] = {0};	/* Conditioning only returns rx[0] */
+		esp_err_t status = samples[i].status;
+		sgp41_cmd_t cmd = SGP41_CMD_MEASURE;
+
+#ifdef CONFIG_SGP41_HEATER
+		/* The state tells which command was sent */
+		if (instances[i]->heater_state == SGP41_HEATER_CONDITIONING) {
+			cmd = SGP41_CMD_CONDITIONING;
+		}
+#endif
+
+		if (status == ESP_OK) {
+			status = cmd_receive(instances[i], cmd, rx);
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+			status = cmd_retry(instances[i], cmd, tx, rx, status, deadline_us);
+#endif
+		}
+
+		sample_fill(instances[i], tx, rx, status, &samples[i]);
+
+		if (status != ESP_OK && ret == ESP_OK) {
+			ret = status;
+		}
+	}
+
+	/* Return the first error, every sample has its own status */
+	return ret;
+}
+
+#ifdef CONFIG_SGP41_LATEST
+/**
+ * @brief Function that returns the latest sample if it is fresh enough,
+ * otherwise measures one shared by every concurrent caller
+ */
+esp_err_t sgp41_get_latest(sgp41_t *const me, uint32_t max_age_ms,
+		                       uint16_t relative_humidity, uint16_t temperature,
+													 sgp41_sample_t *sample) {
+	if (me == NULL || sample == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* A measurement finished after this point was started for this caller */
+	uint32_t generation = __atomic_load_n(&me->latest_generation,
+			__ATOMIC_ACQUIRE);
+
+	/* Callers arriving during a measurement wait here for its result */
+	xSemaphoreTake(me->latest_lock, portMAX_DELAY);
+
+	if (me->latest_generation == generation && (!me->latest_valid ||
+			NOW_US() - me->latest.timestamp_us > (int64_t)max_age_ms * 1000)) {
+		sgp41_measure(me, relative_humidity, temperature, &me->latest);
+
+		/* A failed measurement is shared with the waiters but never cached */
+		me->latest_valid = me->latest.status == ESP_OK;
+		__atomic_store_n(&me->latest_generation, generation + 1, __ATOMIC_RELEASE);
+	}
+
+	*sample = me->latest;
+
+	xSemaphoreGive(me->latest_lock);
+
+	return sample->status;
+}
+#endif /* CONFIG_SGP41_LATEST */
+
+#ifdef CONFIG_SGP41_QUEUE
+/**
+ * @brief Function that queues a command and waits for its result
+ */
+esp_err_t sgp41_request(sgp41_t *const me, sgp41_cmd_t cmd, uint8_t priority,
+		                    const uint16_t *tx, uint16_t *rx) {
+	if (me == NULL || cmd >= SGP41_CMD_MAX ||
+			(sgp41_codec_descs[cmd].tx_words > 0 && tx == NULL) ||
+			(sgp41_codec_descs[cmd].rx_words > 0 && rx == NULL)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	sgp41_request_t request = {
+			.cmd = cmd,
+			.priority = priority
+	};
+
+	for (uint8_t i = 0; i < sgp41_codec_descs[cmd].tx_words; i++) {
+		request.tx[i] = tx[i];
+	}
+
+	queue_submit(me, &request);
+
+	for (uint8_t i = 0; i < sgp41_codec_descs[cmd].rx_words; i++) {
+		rx[i] = request.rx[i];
+	}
+
+	return request.status;
+}
+
+/**
+ * @brief Function that queues a measurement and waits for its sample
+ */
+esp_err_t sgp41_request_measure(sgp41_t *const me, uint8_t priority,
+		                            uint16_t relative_humidity,
+																uint16_t temperature, sgp41_sample_t *sample) {
+	if (me == NULL || sample == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	sgp41_request_t request = {
+			.cmd = SGP41_CMD_MEASURE,
+			.priority = priority,
+			.tx = {relative_humidity, temperature}
+	};
+
+	queue_submit(me, &request);
+
+	*sample = request.sample;
+
+	return request.status;
+}
+#endif /* CONFIG_SGP41_QUEUE */
+
+/**
+ * @brief Function that triggers the built-in self-test checking for integrity
+ * of both hotplate and MOX material and returns the result of this test as 2
+ * bytes.
+ */
+esp_err_t sgp41_execute_self_test(sgp41_t *const me, uint16_t *test_result) {
+	/* Execute a self test */
+	esp_err_t ret = cmd_execute(me, SGP41_CMD_SELF_TEST, NULL, test_result);
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+	/* Keep the decoded result */
+	sgp41_self_test_decode(*test_result, &me->self_test);
+	me->self_test.timestamp_us = NOW_US();
+
+	if (*test_result & SGP41_SELF_TEST_MASK) {
+		COUNTER_INC(me, self_test_failures);
+	}
+
+	if (!me->self_test.pixel_ok[SGP41_PIXEL_VOC]) {
+		COUNTER_INC(me, voc_pixel_failures);
+	}
+
+	if (!me->self_test.pixel_ok[SGP41_PIXEL_NOX]) {
+		COUNTER_INC(me, nox_pixel_failures);
+	}
+
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+	me->self_test_history[me->self_test_head++ %
+			CONFIG_SGP41_SELF_TEST_HISTORY_SIZE] =
+					(uint32_t)(me->self_test.timestamp_us / 1000000) << 4 |
+					(*test_result & SGP41_SELF_TEST_MASK);
+#endif
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function that decodes the pixel pass/fail bits of a self test result
+ */
+void sgp41_self_test_decode(uint16_t test_result, sgp41_self_test_t *self_test) {
+	*self_test = (sgp41_self_test_t) {
+			.raw = test_result,
+			.pixel_ok = {
+					[SGP41_PIXEL_VOC] = !(test_result & SGP41_SELF_TEST_VOC_FAIL),
+					[SGP41_PIXEL_NOX] = !(test_result & SGP41_SELF_TEST_NOX_FAIL)
+			}
+	};
+}
+
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+/**
+ * @brief Function that copies the self test history of an instance
+ */
+size_t sgp41_self_test_get_history(const sgp41_t *const me, uint32_t *entries,
+		                               size_t entries_len) {
+	if (me == NULL || entries == NULL) {
+		return 0;
+	}
+
+	uint32_t head = me->self_test_head;
+	uint32_t stored = head < CONFIG_SGP41_SELF_TEST_HISTORY_SIZE ?
+			head : CONFIG_SGP41_SELF_TEST_HISTORY_SIZE;
+
+	/* Keep the most recent entries when the array is smaller than the ring */
+	size_t count = stored < entries_len ? stored : entries_len;
+
+	for (size_t i = 0; i < count; i++) {
+		entries[i] = me->self_test_history[(head - count + i) %
+				CONFIG_SGP41_SELF_TEST_HISTORY_SIZE];
+	}
+
+	return count;
+}
+
+/**
+ * @brief Function that summarizes the self test history of an instance per
+ * pixel
+ */
+esp_err_t sgp41_self_test_get_trend(const sgp41_t *const me,
+		                                sgp41_self_test_trend_t *trend) {
+	if (me == NULL || trend == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	static const uint16_t fail_bits[SGP41_PIXEL_MAX] = {
+			[SGP41_PIXEL_VOC] = SGP41_SELF_TEST_VOC_FAIL,
+			[SGP41_PIXEL_NOX] = SGP41_SELF_TEST_NOX_FAIL
+	};
+
+	uint32_t head = me->self_test_head;
+
+	*trend = (sgp41_self_test_trend_t) {
+			.tests = head < CONFIG_SGP41_SELF_TEST_HISTORY_SIZE ?
+					head : CONFIG_SGP41_SELF_TEST_HISTORY_SIZE
+	};
+
+	/* Walk from the latest test back, streaks end at the first pass */
+	for (uint8_t p = 0; p < SGP41_PIXEL_MAX; p++) {
+		bool in_streak = true;
+
+		for (uint16_t i = 1; i <= trend->tests; i++) {
+			uint32_t entry =
+					me->self_test_history[(head - i) % CONFIG_SGP41_SELF_TEST_HISTORY_SIZE];
+
+			if (SGP41_SELF_TEST_ENTRY_BITS(entry) & fail_bits[p]) {
+				trend->failures[p]++;
+
+				if (in_streak) {
+					trend->streak[p]++;
+				}
+			}
+			else {
+				in_streak = false;
+			}
+		}
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_SGP41_SELF_TEST_HISTORY */
+
+#ifdef CONFIG_SGP41_HEALTH
+/**
+ * @brief Function that runs the periodic health check in a gap of the sampling
+ * schedule
+ */
+esp_err_t sgp41_health_poll(sgp41_t *const me, uint32_t gap_ms, bool *ran) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (ran != NULL) {
+		*ran = false;
+	}
+
+	int64_t now = NOW_US();
+
+	if (now < me->health_due_us) {
+		return ESP_OK;
+	}
+
+	/* Wait for a gap the self test fits in, unless it has waited too long */
+	bool fits = (uint64_t)gap_ms * 1000 >=
+			sgp41_codec_descs[SGP41_CMD_SELF_TEST].wait_us + HEALTH_MARGIN_US;
+
+	if (!fits && now - me->health_due_us <
+			CONFIG_SGP41_HEALTH_MAX_DELAY_S * 1000000LL) {
+		return ESP_OK;
+	}
+
+	uint16_t test_result = 0;
+	esp_err_t ret = sgp41_execute_self_test(me, &test_result);
+
+	sgp41_health_record_t *record =
+			&me->health[me->health_head++ % CONFIG_SGP41_HEALTH_HISTORY_SIZE];
+
+	*record = (sgp41_health_record_t) {
+			.timestamp_us = NOW_US(),
+			.status = ret,
+			.test_result = test_result
+	};
+
+	if (!fits) {
+		/* The next sample is late, flag it */
+		record->flags |= SGP41_HEALTH_FORCED;
+		me->health_gap = true;
+		COUNTER_INC(me, health_skips);
+		LOG(W, HEALTH_FORCED, me->id);
+	}
+
+	LOG(D, HEALTH, me->id, ret, test_result);
+
+	/* Count the period from this check, overdue checks are not made up for */
+	me->health_due_us = now + CONFIG_SGP41_HEALTH_PERIOD_S * 1000000LL;
+
+	if (ran != NULL) {
+		*ran = true;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Function that copies the latest health checks of an instance
+ */
+size_t sgp41_health_get_history(const sgp41_t *const me,
+		                            sgp41_health_record_t *records,
+																size_t records_len) {
+	if (me == NULL || records == NULL) {
+		return 0;
+	}
+
+	uint32_t head = me->health_head;
+	uint32_t stored = head < CONFIG_SGP41_HEALTH_HISTORY_SIZE ?
+			head : CONFIG_SGP41_HEALTH_HISTORY_SIZE;
+
+	/* Keep the most recent records when the array is smaller than the ring */
+	size_t count = stored < records_len ? stored : records_len;
+
+	for (size_t i = 0; i < count; i++) {
+		records[i] =
+				me->health[(head - count + i) % CONFIG_SGP41_HEALTH_HISTORY_SIZE];
+	}
+
+	return count;
+}
+#endif /* CONFIG_SGP41_HEALTH */
+
+/**
+ * @brief Function that turns the hotplate off and stops the
+ * measurement. Subsequently, the sensor enters the idle mode.
+ */
+esp_err_t sgp41_turn_heater_off(sgp41_t *const me) {
+	/* Turn off the heater */
+	return cmd_execute(me, SGP41_CMD_HEATER_OFF, NULL, NULL);
+}
+
+#ifdef CONFIG_SGP41_HEATER
+/**
+ * @brief Function that returns the heater state of an instance
+ */
+sgp41_heater_state_t sgp41_heater_get_state(sgp41_t *const me, uint32_t *on_ms) {
+	int64_t now = NOW_US();
+
+	/* Warm-up ends with time, not with a command */
+	if (me->heater_state == SGP41_HEATER_WARMING_UP &&
+			now - me->heater_on_us >= CONFIG_SGP41_HEATER_WARM_UP_MS * 1000LL) {
+		me->heater_state = SGP41_HEATER_ON;
+	}
+
+	if (on_ms != NULL) {
+		*on_ms = me->heater_state == SGP41_HEATER_OFF ?
+				0 : (uint32_t)((now - me->heater_on_us) / 1000);
+	}
+
+	return me->heater_state;
+}
+#endif /* CONFIG_SGP41_HEATER */
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+/**
+ * @brief Function that runs the heater power manager of an instance
+ */
+esp_err_t sgp41_heater_poll(sgp41_t *const me) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	int64_t now = NOW_US();
+	sgp41_heater_state_t state = sgp41_heater_get_state(me, NULL);
+
+	if (me->need_us != 0 && now >= me->need_us) {
+		/* The need has started, samples keep the heater on from now */
+		me->need_us = 0;
+		me->demand_us = now;
+	}
+
+	/* Warm up so the sensor is ready when the need starts */
+	if (me->need_us != 0 && now >= me->need_us - HEATER_READY_MS * 1000LL) {
+		if (state == SGP41_HEATER_ON) {
+			return ESP_OK;
+		}
+
+		if (state == SGP41_HEATER_OFF) {
+			me->prewarms++;
+		}
+
+		/* Keep conditioning or measuring, the result is not a sample */
+		const uint16_t tx[2] = {SGP41_DEFAULT_RH, SGP41_DEFAULT_T};
+		uint16_t rx[2];
+
+		return cmd_execute(me, heater_measure_cmd(me), tx, rx);
+	}
+
+	if (state != SGP41_HEATER_OFF &&
+			now - me->demand_us >= CONFIG_SGP41_HEATER_IDLE_TIMEOUT_S * 1000000LL) {
+		esp_err_t ret = sgp41_turn_heater_off(me);
+
+		if (ret == ESP_OK) {
+			me->idle_offs++;
+		}
+
+		return ret;
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that sets when data will be needed next
+ */
+esp_err_t sgp41_heater_schedule(sgp41_t *const me, int64_t need_us) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	me->need_us = need_us;
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that returns the heater duty cycle and the estimated energy
+ * of an instance
+ */
+esp_err_t sgp41_heater_get_power_stats(sgp41_t *const me,
+		                                   sgp41_heater_power_stats_t *stats) {
+	if (me == NULL || stats == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	int64_t now = NOW_US();
+	uint64_t on_us = me->power_on_us;
+
+	/* Add the current on period */
+	if (me->heater_state != SGP41_HEATER_OFF) {
+		on_us += now - me->heater_on_us;
+	}
+
+	uint64_t total_us = now - me->power_start_us;
+	uint64_t off_us = total_us - on_us;
+
+	/* ms x uA x mV is pJ */
+	*stats = (sgp41_heater_power_stats_t) {
+			.total_us = total_us,
+			.on_us = on_us,
+			.duty_permille = total_us > 0 ? (uint16_t)(on_us * 1000 / total_us) : 0,
+			.energy_uj = (on_us / 1000 * CONFIG_SGP41_HEATER_ON_CURRENT_UA +
+					off_us / 1000 * CONFIG_SGP41_HEATER_IDLE_CURRENT_UA) *
+							CONFIG_SGP41_HEATER_SUPPLY_MV / 1000000,
+			.idle_offs = me->idle_offs,
+			.prewarms = me->prewarms
+	};
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_SGP41_HEATER_POWER */
+
+/**
+ * @brief Function that provides the decimal serial number of the SGP41 chip by
+ * returning 3x2 bytes.
+ */
+esp_err_t sgp41_get_serial_number(sgp41_t *const me, uint16_t *serial_number) {
+	/* Get the serial number */
+	return cmd_execute(me, SGP41_CMD_SERIAL, NULL, serial_number);
+}
+
+#ifdef CONFIG_SGP41_CPU_STATS
+/**
+ * @brief Function that copies the CPU time a SGP41 instance has spent
+ * busy-waiting for the sensor, next to the time spent on the I2C bus
+ */
+esp_err_t sgp41_get_cpu_stats(sgp41_t *const me, sgp41_cpu_stats_t *stats) {
+	if (me == NULL || stats == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memcpy(stats, &me->cpu, sizeof(*stats));
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that clears the CPU time accounting of a SGP41 instance
+ */
+esp_err_t sgp41_reset_cpu_stats(sgp41_t *const me) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(&me->cpu, 0, sizeof(me->cpu));
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_SGP41_CPU_STATS */
+
+#ifdef CONFIG_SGP41_LATENCY_STATS
+/**
+ * @brief Function that copies the latency histograms of a SGP41 instance
+ */
+esp_err_t sgp41_get_latency_stats(sgp41_t *const me,
+		                              sgp41_latency_stats_t *stats) {
+	if (me == NULL || stats == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memcpy(stats, &me->latency, sizeof(*stats));
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that clears the latency histograms of a SGP41 instance
+ */
+esp_err_t sgp41_reset_latency_stats(sgp41_t *const me) {
+	if (me == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(&me->latency, 0, sizeof(me->latency));
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_SGP41_LATENCY_STATS */
+
+/**
+ * @brief Function that returns the name of a command
+ */
+const char *sgp41_cmd_name(sgp41_cmd_t cmd) {
+	return cmd < SGP41_CMD_MAX ? cmd_names[cmd] : "unknown";
+}
+
+/**
+ * @brief Function that returns the name of a command phase
+ */
+const char *sgp41_phase_name(sgp41_phase_t phase) {
+	return phase < SGP41_PHASE_MAX ? phase_names[phase] : "unknown";
+}
+
+#ifdef CONFIG_SGP41_METRICS
+/**
+ * @brief Function that returns the table of counters exposed by every instance
+ */
+const sgp41_metric_desc_t *sgp41_metrics_get_descs(size_t *count) {
+	if (count != NULL) {
+		*count = sizeof(metric_descs) / sizeof(metric_descs[0]);
+	}
+
+	return metric_descs;
+}
+
+/**
+ * @brief Function that reads one counter of a SGP41 instance
+ */
+uint32_t sgp41_metrics_read(const sgp41_t *const me, size_t index) {
+	if (me == NULL || index >= sizeof(metric_descs) / sizeof(metric_descs[0])) {
+		return 0;
+	}
+
+	return *(const uint32_t *)((const uint8_t *)&me->counters +
+			metric_descs[index].offset);
+}
+
+/**
+ * @brief Function that keeps registered instances from being released
+ */
+void sgp41_metrics_acquire(void) {
+	portENTER_CRITICAL(&instances_lock);
+	instances_readers++;
+	portEXIT_CRITICAL(&instances_lock);
+}
+
+/**
+ * @brief Function that allows registered instances to be released again
+ */
+void sgp41_metrics_release(void) {
+	portENTER_CRITICAL(&instances_lock);
+	instances_readers--;
+	portEXIT_CRITICAL(&instances_lock);
+}
+
+/**
+ * @brief Function that returns the first registered SGP41 instance
+ */
+sgp41_t *sgp41_metrics_first_instance(void) {
+	return instances;
+}
+
+/**
+ * @brief Function that returns the registered instance following another one
+ */
+sgp41_t *sgp41_metrics_next_instance(const sgp41_t *const me) {
+	return me != NULL ? me->next : NULL;
+}
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+/**
+ * @brief Function that times the driver hot paths and prints the results as
+ * JSON lines
+ */
+esp_err_t sgp41_benchmark_run(sgp41_t *const me, uint32_t iterations,
+		                          FILE *stream) {
+	if (iterations == 0 || stream == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (!benchmark_begin()) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	/* Three 0xBEEF words with their valid CRC, so decoding never fails */
+	static const uint8_t response[9] = {0xBE, 0xEF, 0x92, 0xBE, 0xEF, 0x92,
+			0xBE, 0xEF, 0x92};
+	static const uint16_t args[SGP41_COMMAND_WORDS_MAX] = {SGP41_DEFAULT_RH,
+			SGP41_DEFAULT_T};
+	volatile uint32_t sink = 0;
+	int64_t start;
+
+	/* CRC generation over one word */
+	start = esp_timer_get_time();
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		sink += sgp41_codec_crc(&response[(i % 3) * 3], 2, CRC_TABLE);
+	}
+
+	benchmark_report(stream, "generate_crc", iterations,
+			esp_timer_get_time() - start);
+
+	/* CRC check over one word */
+	start = esp_timer_get_time();
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		sink += sgp41_codec_crc(&response[(i % 3) * 3], 2, CRC_TABLE) ==
+				response[(i % 3) * 3 + 2];
+	}
+
+	benchmark_report(stream, "check_crc", iterations,
+			esp_timer_get_time() - start);
+
+	/* Measure command frame encoding */
+	start = esp_timer_get_time();
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		uint8_t buffer[SGP41_CODEC_FRAME_LEN_MAX];
+		sink += sgp41_codec_encode(SGP41_CMD_MEASURE, args, CRC_TABLE, buffer);
+		sink += buffer[i % sizeof(buffer)];
+	}
+
+	benchmark_report(stream, "encode_frame", iterations,
+			esp_timer_get_time() - start);
+
+	/* Serial number response decoding, the longest response */
+	start = esp_timer_get_time();
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		uint16_t words[SGP41_RESPONSE_WORDS_MAX];
+		sink += sgp41_codec_decode(SGP41_CMD_SERIAL, response, CRC_TABLE, words);
+		sink += words[i % SGP41_RESPONSE_WORDS_MAX];
+	}
+
+	benchmark_report(stream, "decode_response", iterations,
+			esp_timer_get_time() - start);
+
+	/* Full measurement round trips against the real sensor */
+	if (me != NULL) {
+		uint32_t round_trips = iterations < BENCHMARK_ROUND_TRIPS_MAX ?
+				iterations : BENCHMARK_ROUND_TRIPS_MAX;
+		uint32_t errors = 0;
+		int64_t min_us = INT64_MAX, max_us = 0, sum_us = 0;
+
+		for (uint32_t i = 0; i < round_trips; i++) {
+			uint16_t sraw_voc, sraw_nox;
+			start = esp_timer_get_time();
+
+			if (sgp41_measure_raw_signals(me, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+					&sraw_voc, &sraw_nox) != ESP_OK) {
+				errors++;
+				continue;
+			}
+
+			int64_t elapsed_us = esp_timer_get_time() - start;
+			sum_us += elapsed_us;
+			min_us = elapsed_us < min_us ? elapsed_us : min_us;
+			max_us = elapsed_us > max_us ? elapsed_us : max_us;
+		}
+
+		uint32_t ok = round_trips - errors;
+		fprintf(stream, "{\"benchmark\":\"measure_round_trip\",\"iterations\":%"
+				PRIu32 ",\"errors\":%" PRIu32 ",\"min_us\":%" PRId64 ",\"mean_us\":%"
+				PRId64 ",\"max_us\":%" PRId64 "}\n", round_trips, errors,
+				ok ? min_us : 0, ok ? sum_us / ok : 0, max_us);
+	}
+
+	(void)sink;
+	benchmark_end();
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that measures the sampling period jitter and deadline
+ * misses of every scheduling mode, optionally under bus and CPU contention
+ */
+esp_err_t sgp41_benchmark_jitter(sgp41_t *const me,
+		                             const sgp41_jitter_config_t *config,
+																 FILE *stream) {
+	if (me == NULL || config == NULL || stream == NULL || config->samples < 2 ||
+			pdMS_TO_TICKS(config->period_ms) == 0 || config->load_duty_pct > 100) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	uint32_t *jitter_us = config->buffer;
+
+	if (jitter_us == NULL) {
+#ifdef CONFIG_SGP41_NO_HEAP
+		return ESP_ERR_INVALID_ARG;
+#else
+		jitter_us = calloc(config->samples - 1, sizeof(uint32_t));
+
+		if (jitter_us == NULL) {
+			return ESP_ERR_NO_MEM;
+		}
+#endif
+	}
+
+	if (!benchmark_begin()) {
+#ifndef CONFIG_SGP41_NO_HEAP
+		if (jitter_us != config->buffer) {
+			free(jitter_us);
+		}
+#endif
+
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	/* Start the competing load at the priority of the sampling task */
+	benchmark_load_t load = {
+			.running = true,
+			.tasks = {NULL},
+			.bus = config->load_bus,
+			.addr = config->load_addr,
+			.duty_pct = config->load_duty_pct == 0 ? 100 : config->load_duty_pct
+	};
+	UBaseType_t priority = uxTaskPriorityGet(NULL);
+	bool cpu_loaded = false, bus_loaded = false;
+
+	if (config->cpu_load) {
+		cpu_loaded = BENCHMARK_LOAD_START(benchmark_cpu_load_task,
+				"sgp41_cpu_load", 0, &load, priority);
+	}
+
+	if (config->load_bus != NULL) {
+		bus_loaded = BENCHMARK_LOAD_START(benchmark_bus_load_task,
+				"sgp41_bus_load", 1, &load, priority);
+	}
+
+	/* Every strategy is measured on this instance, which keeps its own after */
+	sgp41_wait_t own_wait = me->wait;
+	int64_t period_us = (int64_t)config->period_ms * 1000;
+
+	for (uint8_t wait = 0; wait < SGP41_WAIT_MAX; wait++) {
+		me->wait = (sgp41_wait_t)wait;
+
+		for (uint8_t schedule = 0; schedule < BENCHMARK_SCHEDULE_MAX; schedule++) {
+			uint32_t misses = 0, errors = 0, measure_max_us = 0;
+
+			/* Start on a tick, so the grid of ticks and the ideal one agree */
+			delay_ticks(1);
+
+			TickType_t last_wake = TICKS_NOW();
+			int64_t first_us = NOW_US(), previous_us = first_us;
+
+			for (uint32_t i = 0; i < config->samples; i++) {
+				TickType_t start_tick = TICKS_NOW();
+				int64_t start_us = NOW_US();
+
+				/* Deviation from the previous period and lateness on the ideal grid */
+				if (i > 0) {
+					int64_t deviation_us = start_us - previous_us - period_us;
+					jitter_us[i - 1] = deviation_us < 0 ? -deviation_us : deviation_us;
+
+					if (start_us - (first_us + i * period_us) > config->deadline_us) {
+						misses++;
+					}
+				}
+
+				previous_us = start_us;
+
+				uint16_t sraw_voc, sraw_nox;
+
+				if (sgp41_measure_raw_signals(me, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+						&sraw_voc, &sraw_nox) != ESP_OK) {
+					errors++;
+				}
+
+				/* The wait strategy shows in how long a measurement takes */
+				uint32_t measure_us = (uint32_t)(NOW_US() - start_us);
+
+				if (measure_us > measure_max_us) {
+					measure_max_us = measure_us;
+				}
+
+				benchmark_pace(schedule, &last_wake, start_tick, config->period_ms);
+			}
+
+			uint32_t count = config->samples - 1;
+			qsort(jitter_us, count, sizeof(uint32_t), benchmark_compare_u32);
+
+			fprintf(stream, "{\"benchmark\":\"jitter\",\"wait\":\"%s\","
+					"\"schedule\":\"%s\",\"period_us\":%" PRId64 ",\"samples\":%" PRIu32
+					",\"cpu_load\":%s,\"bus_load\":%s,\"bus_duty_pct\":%u,\"p50_us\":%"
+					PRIu32 ",\"p99_us\":%" PRIu32 ",\"max_us\":%" PRIu32
+					",\"deadline_misses\":%" PRIu32 ",\"measure_max_us\":%" PRIu32
+					",\"errors\":%" PRIu32 "}\n",
+					wait_names[wait],
+					schedule == BENCHMARK_SCHEDULE_ABSOLUTE ? "absolute" : "relative",
+					period_us, config->samples, cpu_loaded ? "true" : "false",
+					bus_loaded ? "true" : "false", bus_loaded ? load.duty_pct : 0,
+					jitter_us[count / 2], jitter_us[(count * 99) / 100],
+					jitter_us[count - 1], misses, measure_max_us, errors);
+		}
+	}
+
+	me->wait = own_wait;
+
+	/* Stop the load and delete its tasks before their storage is reused */
+	benchmark_load_stop(&load);
+
+#ifndef CONFIG_SGP41_NO_HEAP
+	if (jitter_us != config->buffer) {
+		free(jitter_us);
+	}
+#endif
+
+	benchmark_end();
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that measures many instances back to back and reports
+ * throughput, memory footprint and error behavior
+ */
+esp_err_t sgp41_benchmark_stress(sgp41_t *const *instances, size_t count,
+		                             uint32_t rounds, FILE *stream) {
+	if (instances == NULL || count == 0 || rounds == 0 || stream == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (!benchmark_begin()) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	uint32_t samples = 0, timeouts = 0, nacks = 0, crc_errors = 0, others = 0;
+
+#ifdef CONFIG_SGP41_METRICS
+	/* Errors are reported for this run only */
+	for (size_t i = 0; i < count; i++) {
+		instances[i]->stress_counters = instances[i]->counters;
+	}
+#endif
+
+	/* The minimum free heap is tracked from here instead of since boot */
+	heap_caps_monitor_local_minimum_free_size_start();
+	size_t free_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+	/* Driver time may be virtual, wall time is what the CPU actually spent */
+	int64_t start = NOW_US(), wall_start = esp_timer_get_time();
+
+	for (uint32_t round = 0; round < rounds; round++) {
+		for (size_t i = 0; i < count; i++) {
+			uint16_t sraw_voc, sraw_nox;
+			esp_err_t ret = sgp41_measure_raw_signals(instances[i],
+					SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sraw_voc, &sraw_nox);
+
+			switch (ret) {
+				case ESP_OK:
+					samples++;
+					break;
+				case ESP_ERR_TIMEOUT:
+					timeouts++;
+					break;
+				case SGP41_ERR_WRITE_NACK:
+				case SGP41_ERR_READ_NACK:
+					nacks++;
+					break;
+				case ESP_ERR_INVALID_CRC:
+					crc_errors++;
+					break;
+				default:
+					others++;
+					break;
+			}
+		}
+	}
+
+	int64_t elapsed_us = NOW_US() - start;
+	int64_t wall_us = esp_timer_get_time() - wall_start;
+	size_t free_after = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+	size_t free_min = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+	heap_caps_monitor_local_minimum_free_size_stop();
+
+	fprintf(stream, "{\"benchmark\":\"stress\",\"instances\":%u,\"rounds\":%"
+			PRIu32 ",\"elapsed_us\":%" PRId64 ",\"wall_us\":%" PRId64 ",\"samples\":%"
+			PRIu32 ",\"samples_per_s\":%.1f,\"timeouts\":%" PRIu32 ",\"nacks\":%"
+			PRIu32 ",\"crc_errors\":%" PRIu32 ",\"other_errors\":%" PRIu32
+			",\"instance_bytes\":%u,\"heap_free_before\":%u,\"heap_free_after\":%u"
+			",\"heap_peak_bytes\":%u}\n", (unsigned)count, rounds, elapsed_us,
+			wall_us, samples, elapsed_us > 0 ? samples * 1e6 / elapsed_us : 0.0,
+			timeouts, nacks, crc_errors, others, (unsigned)sizeof(sgp41_t),
+			(unsigned)free_before, (unsigned)free_after,
+			(unsigned)(free_before > free_min ? free_before - free_min : 0));
+
+#ifdef CONFIG_SGP41_METRICS
+	/* Detail the instances that saw errors, so bad buses stand out */
+	size_t descs_len;
+	const sgp41_metric_desc_t *descs = sgp41_metrics_get_descs(&descs_len);
+
+	for (size_t i = 0; i < count; i++) {
+		bool failed = false;
+
+		for (size_t j = 0; j < descs_len && !failed; j++) {
+			failed = benchmark_counter_delta(instances[i], j) > 0;
+		}
+
+		if (!failed) {
+			continue;
+		}
+
+		fprintf(stream, "{\"benchmark\":\"stress_errors\",\"instance\":%u",
+				instances[i]->id);
+
+		for (size_t j = 0; j < descs_len; j++) {
+			fprintf(stream, ",\"%s\":%" PRIu32, descs[j].name,
+					benchmark_counter_delta(instances[i], j));
+		}
+
+		fprintf(stream, "}\n");
+	}
+#endif /* CONFIG_SGP41_METRICS */
+
+	benchmark_end();
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_SGP41_BENCHMARK */
+
+#ifdef CONFIG_SGP41_TRACE
+/**
+ * @brief Function that copies the recorded bus transactions of all instances,
+ * oldest first
+ */
+size_t sgp41_trace_snapshot(sgp41_trace_event_t *events, size_t events_len) {
+	if (events == NULL) {
+		return 0;
+	}
+
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+	uint32_t stored = head < CONFIG_SGP41_TRACE_RING_SIZE ?
+			head : CONFIG_SGP41_TRACE_RING_SIZE;
+
+	/* Keep the most recent events when the array is smaller than the ring */
+	uint32_t count = stored < events_len ? stored : (uint32_t)events_len;
+	size_t copied = 0;
+
+	/* Events overwritten or being written meanwhile are skipped */
+	for (uint32_t number = head - count; number != head; number++) {
+		copied += ring_copy(trace_stamps, number, CONFIG_SGP41_TRACE_RING_SIZE,
+				&events[copied],
+				&trace_ring[RING_SLOT(number, CONFIG_SGP41_TRACE_RING_SIZE)],
+				sizeof(sgp41_trace_event_t));
+	}
+
+	return copied;
+}
+
+/**
+ * @brief Function that prints the recorded bus transactions as Chrome trace
+ * event JSON
+ */
+esp_err_t sgp41_trace_dump_json(FILE *stream) {
+	if (stream == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+	uint32_t count = head < CONFIG_SGP41_TRACE_RING_SIZE ?
+			head : CONFIG_SGP41_TRACE_RING_SIZE;
+
+	fprintf(stream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	const char *separator = "";
+
+	for (uint32_t number = head - count; number != head; number++) {
+		sgp41_trace_event_t event;
+
+		/* Events overwritten or being written meanwhile are skipped */
+		if (!ring_copy(trace_stamps, number, CONFIG_SGP41_TRACE_RING_SIZE, &event,
+				&trace_ring[RING_SLOT(number, CONFIG_SGP41_TRACE_RING_SIZE)],
+				sizeof(event))) {
+			continue;
+		}
+
+		fprintf(stream, "%s\n{\"name\":\"%s.%s\",\"cat\":\"sgp41\",\"ph\":\"X\","
+				"\"ts\":%" PRId64 ",\"dur\":%" PRIu32 ",\"pid\":0,\"tid\":%u",
+				separator, cmd_names[event.command], phase_names[event.phase],
+				event.timestamp_us, event.duration_us, event.instance);
+
+		/* Failed phases carry the error that ended them */
+		if (event.status != ESP_OK) {
+			fprintf(stream, ",\"args\":{\"status\":\"%s\"}",
+					esp_err_to_name(event.status));
+		}
+
+		fputc('}', stream);
+		separator = ",";
+	}
+
+	fprintf(stream, "\n]}\n");
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that prints the recorded bus transactions in the raw format
+ * read by tools/sgp41_trace_to_chrome.py
+ */
+esp_err_t sgp41_trace_dump(FILE *stream) {
+	if (stream == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+	uint32_t count = head < CONFIG_SGP41_TRACE_RING_SIZE ?
+			head : CONFIG_SGP41_TRACE_RING_SIZE;
+
+	for (uint32_t number = head - count; number != head; number++) {
+		sgp41_trace_event_t event;
+
+		if (!ring_copy(trace_stamps, number, CONFIG_SGP41_TRACE_RING_SIZE, &event,
+				&trace_ring[RING_SLOT(number, CONFIG_SGP41_TRACE_RING_SIZE)],
+				sizeof(event))) {
+			continue;
+		}
+
+		fprintf(stream, "sgp41_trace %" PRId64 " %" PRIu32 " %u %u %u %d\n",
+				event.timestamp_us, event.duration_us, event.instance, event.command,
+				event.phase, (int)event.status);
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that discards every recorded bus transaction
+ */
+void sgp41_trace_clear(void) {
+	__atomic_store_n(&trace_head, 0, __ATOMIC_RELAXED);
+
+	/* Old stamps would match the record numbers used again */
+	for (uint32_t i = 0; i < CONFIG_SGP41_TRACE_RING_SIZE; i++) {
+		__atomic_store_n(&trace_stamps[i], 0, __ATOMIC_RELAXED);
+	}
+}
+#endif /* CONFIG_SGP41_TRACE */
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+/**
+ * @brief Function that copies the recorded log messages, oldest first
+ */
+size_t sgp41_log_snapshot(sgp41_log_record_t *records, size_t records_len) {
+	if (records == NULL) {
+		return 0;
+	}
+
+	uint32_t head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+	uint32_t stored = head < CONFIG_SGP41_BINARY_LOG_RING_SIZE ?
+			head : CONFIG_SGP41_BINARY_LOG_RING_SIZE;
+
+	/* Keep the most recent records when the array is smaller than the ring */
+	uint32_t count = stored < records_len ? stored : (uint32_t)records_len;
+	size_t copied = 0;
+
+	/* Records overwritten or being written meanwhile are skipped */
+	for (uint32_t number = head - count; number != head; number++) {
+		copied += ring_copy(log_stamps, number, CONFIG_SGP41_BINARY_LOG_RING_SIZE,
+				&records[copied],
+				&log_ring[RING_SLOT(number, CONFIG_SGP41_BINARY_LOG_RING_SIZE)],
+				sizeof(sgp41_log_record_t));
+	}
+
+	return copied;
+}
+
+/**
+ * @brief Function that prints the recorded log messages in the raw format read
+ * by tools/sgp41_log_decode.py
+ */
+esp_err_t sgp41_log_dump(FILE *stream) {
+	if (stream == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	uint32_t head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+	uint32_t count = head < CONFIG_SGP41_BINARY_LOG_RING_SIZE ?
+			head : CONFIG_SGP41_BINARY_LOG_RING_SIZE;
+
+	for (uint32_t number = head - count; number != head; number++) {
+		sgp41_log_record_t record;
+
+		/* Records overwritten or being written meanwhile are skipped */
+		if (!ring_copy(log_stamps, number, CONFIG_SGP41_BINARY_LOG_RING_SIZE,
+				&record,
+				&log_ring[RING_SLOT(number, CONFIG_SGP41_BINARY_LOG_RING_SIZE)],
+				sizeof(record))) {
+			continue;
+		}
+
+		fprintf(stream, "sgp41_log %" PRId64 " %u %" PRIx32 " %" PRIx32 " %"
+				PRIx32 "\n", record.timestamp_us, record.id, record.args[0],
+				record.args[1], record.args[2]);
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that discards every recorded log message
+ */
+void sgp41_log_clear(void) {
+	__atomic_store_n(&log_head, 0, __ATOMIC_RELAXED);
+
+	/* Old stamps would match the record numbers used again */
+	for (uint32_t i = 0; i < CONFIG_SGP41_BINARY_LOG_RING_SIZE; i++) {
+		__atomic_store_n(&log_stamps[i], 0, __ATOMIC_RELAXED);
+	}
+}
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that executes a command: sends its code and argument words,
+ * waits for the sensor and reads and checks the response words
+ */
+static esp_err_t cmd_execute(sgp41_t *const me, sgp41_cmd_t cmd,
+		                         const uint16_t *tx, uint16_t *rx) {
+	cmd_io_ctx_t ctx;
+	esp_err_t ret = cmd_transfer(me, cmd, tx, rx, &ctx);
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+	/* The budget is for the retries, it starts once the response is ready */
+	ret = cmd_retry(me, cmd, tx, rx, ret,
+			ctx.ready_us + CONFIG_SGP41_CRC_RETRY_BUDGET_MS * 1000LL);
+#endif
+
+	return ret;
+}
+
+/**
+ * @brief Function that executes a command once through the codec executor
+ */
+static esp_err_t cmd_transfer(sgp41_t *const me, sgp41_cmd_t cmd,
+		                          const uint16_t *tx, uint16_t *rx,
+															cmd_io_ctx_t *ctx) {
+	uint8_t data_tx[SGP41_CODEC_FRAME_LEN_MAX];
+	size_t frame_len;
+	const uint8_t *frame = cmd_frame(cmd, tx, data_tx, &frame_len);
+	uint8_t decoded = 0;
+
+	io_start(ctx, me, cmd);
+
+	/* Same write, wait, read and CRC sequence as sgp41.hpp */
+	esp_err_t ret = sgp41_codec_execute(cmd, frame, frame_len, &cmd_io, ctx,
+			CRC_TABLE, rx, &decoded);
+
+	return io_check(ctx, ret, decoded);
+}
+
+/**
+ * @brief Function that returns the frame of a command
+ */
+static const uint8_t *cmd_frame(sgp41_cmd_t cmd, const uint16_t *tx,
+		                            uint8_t *buffer, size_t *frame_len) {
+	/* Serialize the command, each argument word followed by its CRC. The
+	 * default compensation is already serialized */
+	if (sgp41_codec_descs[cmd].tx_words == 2 && tx[0] == SGP41_DEFAULT_RH &&
+			tx[1] == SGP41_DEFAULT_T) {
+		*frame_len = sizeof(default_frames[cmd]);
+
+		return default_frames[cmd];
+	}
+
+	*frame_len = sgp41_codec_encode(cmd, tx, CRC_TABLE, buffer);
+
+	return buffer;
+}
+
+/**
+ * @brief Function that sends the code and argument words of a command
+ */
+static esp_err_t cmd_send(sgp41_t *const me, sgp41_cmd_t cmd,
+		                      const uint16_t *tx) {
+	uint8_t data_tx[SGP41_CODEC_FRAME_LEN_MAX];
+	size_t frame_len;
+	const uint8_t *frame = cmd_frame(cmd, tx, data_tx, &frame_len);
+	cmd_io_ctx_t ctx;
+
+	io_start(&ctx, me, cmd);
+
+	return io_write(&ctx, frame, frame_len);
+}
+
+/**
+ * @brief Function that reads and checks the response words of a command
+ */
+static esp_err_t cmd_receive(sgp41_t *const me, sgp41_cmd_t cmd, uint16_t *rx) {
+	cmd_io_ctx_t ctx;
+	uint8_t decoded = 0;
+
+	io_start(&ctx, me, cmd);
+
+	esp_err_t ret = sgp41_codec_receive(cmd, &cmd_io, &ctx, CRC_TABLE, rx,
+			&decoded);
+
+	return io_check(&ctx, ret, decoded);
+}
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+/**
+ * @brief Function that retries a command whose response failed the CRC check
+ */
+static esp_err_t cmd_retry(sgp41_t *const me, sgp41_cmd_t cmd,
+		                       const uint16_t *tx, uint16_t *rx, esp_err_t ret,
+													 int64_t deadline_us) {
+	const sgp41_codec_desc_t *desc = &sgp41_codec_descs[cmd];
+	bool reread = desc->reread;
+
+	me->retries = 0;
+
+	while (ret == ESP_ERR_INVALID_CRC &&
+			me->retries < CONFIG_SGP41_CRC_RETRY_MAX) {
+		/* Reading again is immediate, executing again takes the processing time */
+		if (NOW_US() + (reread ? 0 : desc->wait_us) > deadline_us) {
+			break;
+		}
+
+		me->retries++;
+		COUNTER_INC(me, crc_retries);
+
+		if (reread) {
+			ret = cmd_receive(me, cmd, rx);
+
+			/* The sensor no longer holds the response, execute the command again */
+			if (ret == SGP41_ERR_READ_NACK) {
+				reread = false;
+				ret = ESP_ERR_INVALID_CRC;
+			}
+
+			continue;
+		}
+
+		cmd_io_ctx_t ctx;
+		ret = cmd_transfer(me, cmd, tx, rx, &ctx);
+	}
+
+	if (ret == ESP_OK && me->retries > 0) {
+		COUNTER_INC(me, crc_recoveries);
+	}
+
+	return ret;
+}
+#endif /* CONFIG_SGP41_CRC_RETRY */
+
+/**
+ * @brief Function that fills a sample record from a measurement result
+ */
+static void sample_fill(sgp41_t *const me, const uint16_t *compensation,
+		                    const uint16_t *rx, esp_err_t status,
+												sgp41_sample_t *sample) {
+	*sample = (sgp41_sample_t) {
+			.timestamp_us = NOW_US(),
+			.seq = me->seq++,
+			.status = status,
+			.relative_humidity = compensation[0],
+			.temperature = compensation[1]
+	};
+
+#ifdef CONFIG_SGP41_HEATER
+	if (sgp41_heater_get_state(me, NULL) != SGP41_HEATER_ON) {
+		sample->flags |= SGP41_SAMPLE_WARM_UP;
+	}
+#endif
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+	/* Every sample is demand, keep the heater on */
+	me->demand_us = sample->timestamp_us;
+#endif
+
+#ifdef CONFIG_SGP41_HEALTH
+	/* The slot before this sample was given to a health check */
+	if (me->health_gap) {
+		sample->flags |= SGP41_SAMPLE_GAP;
+		me->health_gap = false;
+	}
+#endif
+
+	if (compensation[0] == SGP41_DEFAULT_RH &&
+			compensation[1] == SGP41_DEFAULT_T) {
+		sample->flags |= SGP41_SAMPLE_UNCOMPENSATED;
+	}
+
+	if (status != ESP_OK) {
+		sample->flags |= SGP41_SAMPLE_INVALID;
+		return;
+	}
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+	if (me->retries > 0) {
+		sample->flags |= SGP41_SAMPLE_RECOVERED;
+	}
+#endif
+
+	sample->sraw_voc = rx[0];
+
+#ifdef CONFIG_SGP41_HEATER
+	/* The conditioning command only returns the VOC signal */
+	if (me->heater_state == SGP41_HEATER_CONDITIONING) {
+		sample->flags |= SGP41_SAMPLE_CONDITIONING;
+		LOG(D, MEASURE, me->id, rx[0], 0);
+
+#ifdef CONFIG_SGP41_METRICS
+		me->sraw_voc = rx[0];
+		me->sample_us = sample->timestamp_us;
+#endif
+		return;
+	}
+#endif
+
+	sample->sraw_nox = rx[1];
+
+	LOG(D, MEASURE, me->id, rx[0], rx[1]);
+
+#ifdef CONFIG_SGP41_METRICS
+	/* Keep the latest sample for exporters */
+	me->sraw_voc = rx[0];
+	me->sraw_nox = rx[1];
+	me->sample_us = sample->timestamp_us;
+#endif
+}
+
+#ifdef CONFIG_SGP41_HEATER
+/**
+ * @brief Function that updates the heater state after a command was written
+ */
+static void heater_track(sgp41_t *const me, sgp41_cmd_t cmd) {
+	switch (cmd) {
+		case SGP41_CMD_CONDITIONING:
+		case SGP41_CMD_MEASURE:
+			if (me->heater_state == SGP41_HEATER_OFF) {
+				me->heater_on_us = NOW_US();
+			}
+
+			/* Warm-up counts from the heater on, conditioning included */
+			if (cmd == SGP41_CMD_CONDITIONING) {
+				me->heater_state = SGP41_HEATER_CONDITIONING;
+			}
+			else if (me->heater_state != SGP41_HEATER_ON) {
+				me->heater_state = SGP41_HEATER_WARMING_UP;
+			}
+			break;
+		case SGP41_CMD_SELF_TEST:
+		case SGP41_CMD_HEATER_OFF:
+#ifdef CONFIG_SGP41_HEATER_POWER
+			/* Close the on period */
+			if (me->heater_state != SGP41_HEATER_OFF) {
+				me->power_on_us += NOW_US() - me->heater_on_us;
+			}
+#endif
+
+			/* The sensor is idle afterwards */
+			me->heater_state = SGP41_HEATER_OFF;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Function that returns the command that measures an instance
+ */
+static sgp41_cmd_t heater_measure_cmd(sgp41_t *const me) {
+#ifdef CONFIG_SGP41_HEATER_AUTO_CONDITIONING
+	/* Condition after the heater was off, for a fixed time from heater on */
+	if (me->heater_state == SGP41_HEATER_OFF ||
+			(me->heater_state == SGP41_HEATER_CONDITIONING &&
+					NOW_US() - me->heater_on_us <
+							CONFIG_SGP41_HEATER_CONDITIONING_MS * 1000LL)) {
+		return SGP41_CMD_CONDITIONING;
+	}
+#endif
+
+	return SGP41_CMD_MEASURE;
+}
+#endif /* CONFIG_SGP41_HEATER */
+
+/**
+ * @brief Function that clears the state of an instance before it is started
+ */
+static void instance_reset(sgp41_t *const me) {
+#ifdef CONFIG_SGP41_LATENCY_STATS
+	/* Clear latency histograms */
+	memset(&me->latency, 0, sizeof(me->latency));
+#endif
+
+#ifdef CONFIG_SGP41_CPU_STATS
+	/* Clear CPU time accounting */
+	memset(&me->cpu, 0, sizeof(me->cpu));
+#endif
+
+#ifdef CONFIG_SGP41_METRICS
+	/* Clear error counters */
+	memset(&me->counters, 0, sizeof(me->counters));
+#endif
+
+#ifdef CONFIG_SGP41_HOOKS
+	/* Talk through the I2C master driver unless told otherwise */
+	me->transport = NULL;
+#endif
+
+#ifdef CONFIG_SGP41_QUEUE
+	/* Empty queue, nobody serving it */
+	me->queue = NULL;
+	portMUX_INITIALIZE(&me->queue_lock);
+	me->queue_owner = xSemaphoreCreateMutexStatic(&me->queue_owner_buffer);
+#endif
+
+	/* Number the instance and restart its sample sequence */
+	me->id = __atomic_fetch_add(&instances_count, 1, __ATOMIC_RELAXED);
+	me->seq = 0;
+
+	/* Wait as configured in Kconfig until told otherwise */
+	me->wait = WAIT_DEFAULT;
+
+	/* No self test run yet */
+	memset(&me->self_test, 0, sizeof(me->self_test));
+
+#ifdef CONFIG_SGP41_HEATER
+	/* The sensor starts idle */
+	me->heater_state = SGP41_HEATER_OFF;
+	me->heater_on_us = 0;
+#endif
+
+#ifdef CONFIG_SGP41_HEATER_POWER
+	/* Account power from now, no need scheduled */
+	me->power_start_us = NOW_US();
+	me->power_on_us = 0;
+	me->demand_us = me->power_start_us;
+	me->need_us = 0;
+	me->idle_offs = 0;
+	me->prewarms = 0;
+#endif
+
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+	me->self_test_head = 0;
+#endif
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+	me->retries = 0;
+#endif
+
+#ifdef CONFIG_SGP41_HEALTH
+	/* First check one period after init */
+	me->health_due_us = NOW_US() + CONFIG_SGP41_HEALTH_PERIOD_S * 1000000LL;
+	me->health_gap = false;
+	me->health_head = 0;
+#endif
+
+#ifdef CONFIG_SGP41_LATEST
+	/* No sample to share yet, the lock lives in the instance */
+	me->latest_valid = false;
+	me->latest_generation = 0;
+	me->latest_lock = xSemaphoreCreateMutexStatic(&me->latest_lock_buffer);
+#endif
+}
+
+/**
+ * @brief Function that runs the self test, reads the serial number and
+ * registers an instance
+ */
+static esp_err_t instance_start(sgp41_t *const me) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+#ifdef CONFIG_SGP41_SELF_TEST_AT_INIT
+	/* Execute selff test */
+	LOG(I, SELF_TEST);
+	uint16_t test_result;
+	ret = sgp41_execute_self_test(me, &test_result);
+
+	if (ret != ESP_OK) {
+		LOG(E, SELF_TEST_ERROR, ret);
+		return ret;
+	}
+
+	if (test_result & SGP41_SELF_TEST_MASK) {
+		LOG(E, SELF_TEST_FAIL, test_result);
+	}
+	else {
+		LOG(I, SELF_TEST_OK);
+	}
+#endif /* CONFIG_SGP41_SELF_TEST_AT_INIT */
+
+	/* Get and print serial number */
+	uint16_t serial_number[3];
+	ret = sgp41_get_serial_number(me, serial_number);
+
+	if (ret != ESP_OK) {
+		LOG(E, SERIAL_ERROR, ret);
+		return ret;
+	}
+
+	LOG(I, SERIAL, serial_number[0], serial_number[1], serial_number[2]);
+
+#ifdef CONFIG_SGP41_METRICS
+	/* Register the instance so its counters can be enumerated, only once it
+	 * answers so a failed init leaves nothing behind */
+	metrics_register(me);
+#endif
+
+	/* Print successful initialization message */
+	LOG(I, INIT_OK);
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function that implements the default I2C read transaction
+ */
+static esp_err_t i2c_read(uint8_t *data, uint32_t data_len, void *intf) {
+	sgp41_t *const me = (sgp41_t *)intf;
+
+	esp_err_t ret;
+
+#ifdef CONFIG_SGP41_HOOKS
+	if (me->transport != NULL) {
+		ret = me->transport->read(me->transport->ctx, data, data_len);
+	}
+	else
+#endif
+	ret = i2c_master_receive(me->i2c_dev, data, data_len,
+			CONFIG_SGP41_I2C_TIMEOUT_MS);
+
+	if (ret == ESP_ERR_TIMEOUT) {
+		COUNTER_INC(me, timeouts);
+		return ESP_ERR_TIMEOUT;
+	}
+	else if (ret != ESP_OK) {
+		COUNTER_INC(me, read_nacks);
+		return SGP41_ERR_READ_NACK;
+	}
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that implements the default I2C write transaction
+ */
+static esp_err_t i2c_write(const uint8_t *frame, uint32_t frame_len,
+		                       void *intf) {
+	sgp41_t *const me = (sgp41_t *)intf;
+
+	/* Transmit frame */
+	esp_err_t ret;
+
+#ifdef CONFIG_SGP41_HOOKS
+	if (me->transport != NULL) {
+		ret = me->transport->write(me->transport->ctx, frame, frame_len);
+	}
+	else
+#endif
+	ret = i2c_master_transmit(me->i2c_dev, frame, frame_len,
+			CONFIG_SGP41_I2C_TIMEOUT_MS);
+
+	if (ret == ESP_ERR_TIMEOUT) {
+		COUNTER_INC(me, timeouts);
+		return ESP_ERR_TIMEOUT;
+	}
+	else if (ret != ESP_OK) {
+		COUNTER_INC(me, write_nacks);
+		return SGP41_ERR_WRITE_NACK;
+	}
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that starts the executor context of a command
+ */
+static void io_start(cmd_io_ctx_t *ctx, sgp41_t *const me, sgp41_cmd_t cmd) {
+	ctx->me = me;
+	ctx->cmd = cmd;
+
+#ifdef PHASE_TIMING
+	ctx->ts = NOW_US();
+#endif
+#ifdef CONFIG_SGP41_CRC_RETRY
+	ctx->ready_us = 0;
+#endif
+}
+
+/**
+ * @brief Executor callback that writes a command frame
+ */
+static int io_write(void *ctx, const uint8_t *data, size_t data_len) {
+	cmd_io_ctx_t *io = (cmd_io_ctx_t *)ctx;
+
+	esp_err_t ret = i2c_write(data, data_len, io->me);
+
+	PHASE_END(io->me, io->cmd, SGP41_PHASE_WRITE, io->ts, ret);
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+#ifdef CONFIG_SGP41_HEATER
+	/* The sensor acts on the command once it is written */
+	heater_track(io->me, io->cmd);
+#endif
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Executor callback that waits for the processing time
+ */
+static void io_wait(void *ctx, uint32_t period_us) {
+	cmd_io_ctx_t *io = (cmd_io_ctx_t *)ctx;
+
+#ifdef PHASE_TIMING
+	/* The heater tracking is not part of the wait */
+	io->ts = NOW_US();
+#endif
+
+	delay_us(io->me, period_us);
+
+	PHASE_END(io->me, io->cmd, SGP41_PHASE_WAIT, io->ts, ESP_OK);
+
+#ifdef CONFIG_SGP41_CRC_RETRY
+	io->ready_us = NOW_US();
+#endif
+}
+
+/**
+ * @brief Executor callback that reads a response
+ */
+static int io_read(void *ctx, uint8_t *data, size_t data_len) {
+	cmd_io_ctx_t *io = (cmd_io_ctx_t *)ctx;
+
+	esp_err_t ret = i2c_read(data, data_len, io->me);
+
+	PHASE_END(io->me, io->cmd, SGP41_PHASE_READ, io->ts, ret);
+
+	return ret;
+}
+
+/**
+ * @brief Function that books the CRC check of a response returned by the
+ * executor
+ */
+static esp_err_t io_check(cmd_io_ctx_t *ctx, esp_err_t ret, uint8_t decoded) {
+	/* The response was read and checked, the read phase left ts at its end */
+	if (ret == ESP_ERR_INVALID_CRC) {
+		COUNTER_INC(ctx->me, crc_errors[decoded]);
+	}
+	else if (ret != ESP_OK || sgp41_codec_descs[ctx->cmd].rx_words == 0) {
+		return ret;
+	}
+
+	PHASE_END(ctx->me, ctx->cmd, SGP41_PHASE_CRC, ctx->ts, ret);
+
+	return ret;
+}
 
 /**
- * @brief Function that implements a micro seconds delay
+ * @brief Function that implements a micro seconds delay with the wait
+ * strategy of an instance
  */
-static void delay_us(uint32_t period_us) {
+static void delay_us(const sgp41_t *const me, uint32_t period_us) {
+	if (me->wait == SGP41_WAIT_TASK_DELAY && period_us > 0) {
+		/* Block the task, rounded up to whole ticks. The first tick interrupt
+		 * can come right away, so one more keeps the wait from being short */
+		TickType_t ticks = (TickType_t)(((uint64_t)period_us * configTICK_RATE_HZ +
+				999999) / 1000000);
+
+		delay_ticks(ticks + 1);
+
+		return;
+	}
+
+#ifdef CONFIG_SGP41_HOOKS
+	if (clock_hook.wait_us != NULL) {
+		clock_hook.wait_us(clock_hook.ctx, period_us);
+		return;
+	}
+#endif
+
 	uint64_t m = (uint64_t)esp_timer_get_time();
 
   if (period_us) {
@@ -397,38 +2725,535 @@ static void delay_us(uint32_t period_us) {
 }
 
 /**
- * @brief Function that generates a CRC byte for a given data
+ * @brief Function that blocks the task until a number of tick interrupts
+ * have passed
  */
-static uint8_t generate_crc(const uint8_t *data, uint16_t count) {
-  uint16_t current_byte;
-  uint8_t crc = CRC8_INIT;
-  uint8_t crc_bit;
+static void delay_ticks(TickType_t ticks) {
+	if (ticks == 0) {
+		return;
+	}
 
-  /* calculates 8-Bit checksum with given polynomial */
-  for (current_byte = 0; current_byte < count; ++current_byte) {
-  	crc ^= (data[current_byte]);
+#ifdef CONFIG_SGP41_HOOKS
+	/* A replaced clock ends the delay on its own tick boundary, where the tick
+	 * interrupt would end vTaskDelay() */
+	if (clock_hook.wait_us != NULL) {
+		int64_t tick_us = portTICK_PERIOD_MS * 1000, now = NOW_US();
+		clock_hook.wait_us(clock_hook.ctx,
+				(uint32_t)((now / tick_us + ticks) * tick_us - now));
+		return;
+	}
+#endif
 
-  	for (crc_bit = 8; crc_bit > 0; --crc_bit) {
-  		if (crc & 0x80) {
-  			crc = (crc << 1) ^ CRC8_POLYNOMIAL;
-  		}
-  		else {
-  			crc = (crc << 1);
-  		}
-  	}
-  }
-  return crc;
+	vTaskDelay(ticks);
+}
+
+#ifdef CONFIG_SGP41_METRICS
+/**
+ * @brief Function that adds an instance to the metrics registry
+ */
+static void metrics_register(sgp41_t *const me) {
+	portENTER_CRITICAL(&instances_lock);
+
+	/* An instance initialized again is moved to the front with its new id, so
+	 * the registry stays ordered by decreasing id */
+	sgp41_t **it = &instances;
+
+	while (*it != NULL && *it != me) {
+		it = &(*it)->next;
+	}
+
+	if (*it != NULL) {
+		*it = me->next;
+	}
+
+	me->next = instances;
+	instances = me;
+
+	portEXIT_CRITICAL(&instances_lock);
+}
+
+/**
+ * @brief Function that removes an instance from the metrics registry
+ */
+static void metrics_unregister(sgp41_t *const me) {
+	portENTER_CRITICAL(&instances_lock);
+
+	sgp41_t **it = &instances;
+
+	while (*it != NULL && *it != me) {
+		it = &(*it)->next;
+	}
+
+	if (*it != NULL) {
+		*it = me->next;
+	}
+
+	portEXIT_CRITICAL(&instances_lock);
+
+	/* Readers may still be on the instance, keep it and its link valid until
+	 * they are done */
+	for (;;) {
+		portENTER_CRITICAL(&instances_lock);
+		uint32_t readers = instances_readers;
+		portEXIT_CRITICAL(&instances_lock);
+
+		if (readers == 0) {
+			break;
+		}
+
+		vTaskDelay(1);
+	}
+
+	me->next = NULL;
+}
+#endif /* CONFIG_SGP41_METRICS */
+
+#ifdef CONFIG_SGP41_BINARY_LOG
+/**
+ * @brief Function that records a log message in the binary log ring
+ */
+static void log_record(uint16_t id, const uint32_t *args) {
+	uint32_t number = ring_claim(&log_head, log_stamps,
+			CONFIG_SGP41_BINARY_LOG_RING_SIZE);
+	sgp41_log_record_t *record =
+			&log_ring[RING_SLOT(number, CONFIG_SGP41_BINARY_LOG_RING_SIZE)];
+
+	/* args[0] is a placeholder that allows messages without arguments */
+	record->timestamp_us = NOW_US();
+	record->id = id;
+	record->args[0] = args[1];
+	record->args[1] = args[2];
+	record->args[2] = args[3];
+
+	ring_publish(log_stamps, number, CONFIG_SGP41_BINARY_LOG_RING_SIZE);
+}
+#endif /* CONFIG_SGP41_BINARY_LOG */
+
+#if defined(CONFIG_SGP41_BINARY_LOG) || defined(CONFIG_SGP41_TRACE)
+/**
+ * @brief Function that claims the next record of a ring
+ */
+static uint32_t ring_claim(uint32_t *head, uint32_t *stamps, uint32_t size) {
+	uint32_t number = __atomic_fetch_add(head, 1, __ATOMIC_RELAXED);
+
+	/* A slot is readable while its stamp is its record number plus 1, any
+	 * other value marks it torn before the fields change */
+	__atomic_store_n(&stamps[RING_SLOT(number, size)], number + 2,
+			__ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return number;
+}
+
+/**
+ * @brief Function that stamps a written record as readable
+ */
+static void ring_publish(uint32_t *stamps, uint32_t number, uint32_t size) {
+	__atomic_store_n(&stamps[RING_SLOT(number, size)], number + 1,
+			__ATOMIC_RELEASE);
 }
 
 /**
- * @brief Function that checks the CRC for the received data
+ * @brief Function that copies a record unless it was overwritten or is being
+ * written
  */
-static bool check_crc(const uint8_t *data, uint16_t count, uint8_t checksum) {
-	if (generate_crc(data, count) != checksum) {
+static bool ring_copy(const uint32_t *stamps, uint32_t number, uint32_t size,
+		                  void *dst, const void *src, size_t len) {
+	const uint32_t *stamp = &stamps[RING_SLOT(number, size)];
+
+	if (__atomic_load_n(stamp, __ATOMIC_ACQUIRE) != number + 1) {
 		return false;
 	}
 
-	return true;
+	memcpy(dst, src, len);
+
+	/* A writer that started meanwhile has changed the stamp */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(stamp, __ATOMIC_RELAXED) == number + 1;
+}
+#endif /* CONFIG_SGP41_BINARY_LOG || CONFIG_SGP41_TRACE */
+
+#ifdef CONFIG_SGP41_BENCHMARK
+/**
+ * @brief Function that orders two uint32_t values for qsort()
+ */
+static int benchmark_compare_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Function that marks a benchmark as running
+ */
+static bool benchmark_begin(void) {
+	return !__atomic_test_and_set(&benchmark_running, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Function that marks the running benchmark as finished
+ */
+static void benchmark_end(void) {
+	__atomic_clear(&benchmark_running, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Function that stops the load tasks and deletes them
+ */
+static void benchmark_load_stop(benchmark_load_t *load) {
+	load->running = false;
+
+	/* A task deleting itself is freed later by the idle task, so the tasks
+	 * park and are deleted here. A suspended task runs on no core, its
+	 * storage is released when vTaskDelete() returns */
+	for (uint8_t i = 0; i < SGP41_BENCHMARK_LOAD_TASKS; i++) {
+		if (load->tasks[i] == NULL) {
+			continue;
+		}
+
+		while (eTaskGetState(load->tasks[i]) != eSuspended) {
+			vTaskDelay(1);
+		}
+
+		vTaskDelete(load->tasks[i]);
+		load->tasks[i] = NULL;
+	}
+}
+
+/**
+ * @brief Function that loads the CPU about half of the time
+ */
+static void benchmark_cpu_load_task(void *arg) {
+	benchmark_load_t *load = (benchmark_load_t *)arg;
+
+	while (load->running) {
+		/* Spin for one tick, then sleep for one */
+		int64_t end = esp_timer_get_time() + portTICK_PERIOD_MS * 1000;
+
+		while (esp_timer_get_time() < end) {
+			NOP();
+		}
+
+		vTaskDelay(1);
+	}
+
+	/* Parked until benchmark_load_stop() deletes the task */
+	vTaskSuspend(NULL);
+}
+
+/**
+ * @brief Function that keeps the bus busy with probes for a share of the time
+ */
+static void benchmark_bus_load_task(void *arg) {
+	benchmark_load_t *load = (benchmark_load_t *)arg;
+	int64_t tick_us = portTICK_PERIOD_MS * 1000, idle_us = 0;
+
+	while (load->running) {
+		int64_t start_us = esp_timer_get_time();
+		i2c_master_probe(load->bus, load->addr, CONFIG_SGP41_I2C_TIMEOUT_MS);
+
+		/* Idle time is owed in proportion to the probing and paid in whole
+		 * ticks, so the duty cycle holds on average over a few ticks */
+		if (load->duty_pct < 100) {
+			idle_us += (esp_timer_get_time() - start_us) * (100 - load->duty_pct) /
+					load->duty_pct;
+
+			if (idle_us >= tick_us) {
+				vTaskDelay((TickType_t)(idle_us / tick_us));
+				idle_us %= tick_us;
+			}
+		}
+	}
+
+	/* Parked until benchmark_load_stop() deletes the task */
+	vTaskSuspend(NULL);
+}
+
+/**
+ * @brief Function that waits for the next sample of the jitter benchmark
+ */
+static void benchmark_pace(uint8_t schedule, TickType_t *last_wake,
+		                       TickType_t start_tick, uint32_t period_ms) {
+	TickType_t period = pdMS_TO_TICKS(period_ms);
+
+	if (schedule == BENCHMARK_SCHEDULE_RELATIVE) {
+		/* Delay for what is left of the period, counted in whole ticks */
+		TickType_t elapsed = TICKS_NOW() - start_tick;
+		delay_ticks(elapsed < period ? period - elapsed : 0);
+
+		return;
+	}
+
+#ifdef CONFIG_SGP41_HOOKS
+	/* A replaced clock wakes up on the same grid of ticks */
+	if (clock_hook.wait_us != NULL) {
+		*last_wake += period;
+		TickType_t now = TICKS_NOW();
+
+		if ((int32_t)(*last_wake - now) > 0) {
+			delay_ticks(*last_wake - now);
+		}
+
+		return;
+	}
+#endif
+
+	xTaskDelayUntil(last_wake, period);
+}
+
+#ifdef CONFIG_SGP41_METRICS
+/**
+ * @brief Function that returns how much a counter grew since the stress run
+ * started
+ */
+static uint32_t benchmark_counter_delta(const sgp41_t *const me, size_t index) {
+	size_t descs_len;
+	const sgp41_metric_desc_t *descs = sgp41_metrics_get_descs(&descs_len);
+	uint32_t baseline = *(const uint32_t *)((const uint8_t *)&me->stress_counters +
+			descs[index].offset);
+
+	return sgp41_metrics_read(me, index) - baseline;
+}
+#endif
+
+/**
+ * @brief Function that prints one benchmark result as a JSON line
+ */
+static void benchmark_report(FILE *stream, const char *name,
+		                         uint32_t iterations, int64_t elapsed_us) {
+	fprintf(stream, "{\"benchmark\":\"%s\",\"iterations\":%" PRIu32
+			",\"total_us\":%" PRId64 ",\"ns_per_op\":%.1f}\n", name, iterations,
+			elapsed_us, (double)elapsed_us * 1000.0 / iterations);
+}
+#endif /* CONFIG_SGP41_BENCHMARK */
+
+#ifdef CONFIG_SGP41_QUEUE
+/**
+ * @brief Function that queues a request and waits for its result
+ */
+static void queue_submit(sgp41_t *const me, sgp41_request_t *request) {
+	request->done = xSemaphoreCreateBinaryStatic(&request->done_buffer);
+	request->task_priority = uxTaskPriorityGet(NULL);
+	request->enqueued_us = NOW_US();
+	request->next = NULL;
+
+	/* Append, so requests of equal priority are served in order */
+	portENTER_CRITICAL(&me->queue_lock);
+
+	sgp41_request_t **tail = &me->queue;
+
+	while (*tail != NULL) {
+		tail = &(*tail)->next;
+	}
+
+	*tail = request;
+
+	portEXIT_CRITICAL(&me->queue_lock);
+
+	/* Serve the queue unless another task does. After releasing it, check
+	 * again: a request queued meanwhile may have found it still taken */
+	while (xSemaphoreTake(me->queue_owner, 0) == pdTRUE) {
+		queue_serve(me);
+		xSemaphoreGive(me->queue_owner);
+
+		portENTER_CRITICAL(&me->queue_lock);
+		bool empty = me->queue == NULL;
+		portEXIT_CRITICAL(&me->queue_lock);
+
+		if (empty) {
+			break;
+		}
+	}
+
+	xSemaphoreTake(request->done, portMAX_DELAY);
+	vSemaphoreDelete(request->done);
+}
+
+/**
+ * @brief Function that executes the pending requests until the queue is empty
+ */
+static void queue_serve(sgp41_t *const me) {
+	UBaseType_t base_priority = uxTaskPriorityGet(NULL);
+
+	for (;;) {
+		portENTER_CRITICAL(&me->queue_lock);
+
+		/* Oldest request of the highest priority */
+		sgp41_request_t *best = me->queue;
+
+		for (sgp41_request_t *it = me->queue; it != NULL; it = it->next) {
+			if (it->priority > best->priority) {
+				best = it;
+			}
+		}
+
+		if (best == NULL) {
+			portEXIT_CRITICAL(&me->queue_lock);
+
+			if (uxTaskPriorityGet(NULL) != base_priority) {
+				vTaskPrioritySet(NULL, base_priority);
+			}
+
+			return;
+		}
+
+		/* Waiting tasks are blocked on this one, serve at their priority */
+		UBaseType_t task_priority = base_priority;
+
+		for (sgp41_request_t *it = me->queue; it != NULL; it = it->next) {
+			if (it->task_priority > task_priority) {
+				task_priority = it->task_priority;
+			}
+		}
+
+		/* Take every request for the same command, the newest arguments win */
+		sgp41_cmd_t cmd = best->cmd;
+		sgp41_request_t *merged = NULL, **merged_tail = &merged, *newest = NULL;
+		sgp41_request_t **it = &me->queue;
+
+		while (*it != NULL) {
+			if ((*it)->cmd == cmd) {
+				newest = *it;
+				*merged_tail = *it;
+				merged_tail = &(*it)->next;
+				*it = (*it)->next;
+			}
+			else {
+				it = &(*it)->next;
+			}
+		}
+
+		*merged_tail = NULL;
+
+		portEXIT_CRITICAL(&me->queue_lock);
+
+		if (uxTaskPriorityGet(NULL) != task_priority) {
+			vTaskPrioritySet(NULL, task_priority);
+		}
+
+#ifdef PHASE_TIMING
+		for (sgp41_request_t *r = merged; r != NULL; r = r->next) {
+			int64_t ts = r->enqueued_us;
+			PHASE_END(me, cmd, SGP41_PHASE_QUEUE, ts, ESP_OK);
+		}
+#endif
+
+		/* One transaction for all of them, through the public functions so the
+		 * queue keeps their bookkeeping */
+		sgp41_sample_t sample = {0};
+		uint16_t rx[SGP41_RESPONSE_WORDS_MAX] = {0};
+		esp_err_t status;
+
+		switch (cmd) {
+			case SGP41_CMD_CONDITIONING:
+				status = sgp41_execute_conditioning(me, newest->tx[0], newest->tx[1],
+						rx);
+				break;
+			case SGP41_CMD_MEASURE:
+				status = sgp41_measure(me, newest->tx[0], newest->tx[1], &sample);
+				rx[0] = sample.sraw_voc;
+				rx[1] = sample.sraw_nox;
+				break;
+			case SGP41_CMD_SELF_TEST:
+				status = sgp41_execute_self_test(me, rx);
+				break;
+			case SGP41_CMD_HEATER_OFF:
+				status = sgp41_turn_heater_off(me);
+				break;
+			default:
+				status = sgp41_get_serial_number(me, rx);
+				break;
+		}
+
+		/* The request may be gone as soon as done is given */
+		while (merged != NULL) {
+			sgp41_request_t *next = merged->next;
+
+			merged->status = status;
+			merged->sample = sample;
+			memcpy(merged->rx, rx, sizeof(rx));
+
+			xSemaphoreGive(merged->done);
+			merged = next;
+		}
+	}
+}
+#endif /* CONFIG_SGP41_QUEUE */
+
+#ifdef PHASE_TIMING
+/**
+ * @brief Function that records the duration of a command phase, failed phases
+ * included so the statistics are not biased toward successful commands
+ */
+static void phase_end(sgp41_t *const me, sgp41_cmd_t cmd, sgp41_phase_t phase,
+		                  int64_t *ts, esp_err_t status) {
+	int64_t now = NOW_US();
+	uint32_t elapsed_us = (uint32_t)(now - *ts);
+
+#ifdef CONFIG_SGP41_TRACE
+	/* Claim a slot in the trace ring, the oldest event is overwritten */
+	uint32_t number = ring_claim(&trace_head, trace_stamps,
+			CONFIG_SGP41_TRACE_RING_SIZE);
+
+	trace_ring[RING_SLOT(number, CONFIG_SGP41_TRACE_RING_SIZE)] =
+			(sgp41_trace_event_t) {
+					.timestamp_us = *ts,
+					.duration_us = elapsed_us,
+					.instance = me->id,
+					.command = cmd,
+					.phase = phase,
+					.status = status
+			};
+
+	ring_publish(trace_stamps, number, CONFIG_SGP41_TRACE_RING_SIZE);
+#endif /* CONFIG_SGP41_TRACE */
+
+	*ts = now;
+
+#ifdef CONFIG_SGP41_CPU_STATS
+	/* The wait phase is spent spinning in delay_us(), unless the task blocks */
+	switch (phase) {
+		case SGP41_PHASE_WRITE:
+			me->cpu.commands[cmd]++;
+			me->cpu.i2c_us[cmd] += elapsed_us;
+			break;
+		case SGP41_PHASE_READ:
+			me->cpu.i2c_us[cmd] += elapsed_us;
+			break;
+		case SGP41_PHASE_WAIT:
+			if (me->wait == SGP41_WAIT_BUSY) {
+				me->cpu.spin_us[cmd] += elapsed_us;
+			}
+			break;
+		default:
+			break;
+	}
+#endif /* CONFIG_SGP41_CPU_STATS */
+
+#ifdef CONFIG_SGP41_LATENCY_STATS
+	/* Select the log2 bucket, 0 and 1 us both go to the first one */
+	uint8_t bucket = 0;
+
+	if (elapsed_us > 0) {
+		bucket = 31 - __builtin_clz(elapsed_us);
+
+		if (bucket >= SGP41_LATENCY_BUCKETS) {
+			bucket = SGP41_LATENCY_BUCKETS - 1;
+		}
+	}
+
+	sgp41_latency_hist_t *hist = &me->latency.hist[cmd][phase];
+	hist->count++;
+	hist->failures += status != ESP_OK;
+	hist->sum_us += elapsed_us;
+	hist->buckets[bucket]++;
+
+	if (elapsed_us > hist->max_us) {
+		hist->max_us = elapsed_us;
+	}
+#endif /* CONFIG_SGP41_LATENCY_STATS */
 }
+#endif /* PHASE_TIMING */
 
 /***************************** END OF FILE ************************************/
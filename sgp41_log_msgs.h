@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_log_msgs.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : SGP41 log message table
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_LOG_MSGS_H_
+#define SGP41_LOG_MSGS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+/* Exported Macros -----------------------------------------------------------*/
+/* Message formats. Arguments must fit in 32 bits, strings are not allowed so
+ * that binary records can be formatted offline by tools/sgp41_log_decode.py */
+#define SGP41_MSG_INIT									"Initializing instance..."
+#define SGP41_MSG_ADD_DEVICE_FAIL				"Failed to add device to I2C bus: 0x%X"
+#define SGP41_MSG_SELF_TEST							"Executing self test..."
+#define SGP41_MSG_SELF_TEST_ERROR				"Failed to execute self test: 0x%X"
+#define SGP41_MSG_SELF_TEST_FAIL				"Self test failed with error: 0x%X"
+#define SGP41_MSG_SELF_TEST_OK					"Self test executed successfully"
+#define SGP41_MSG_SERIAL_ERROR					"Failed to get serial number: 0x%X"
+#define SGP41_MSG_SERIAL								"Serial number: 0X%04X%04X%04X"
+#define SGP41_MSG_INIT_OK								"Instance initialized successfully"
+#define SGP41_MSG_MEASURE								"Instance %u: SRAW_VOC %u, SRAW_NOX %u"
+#define SGP41_MSG_HEALTH								"Instance %u: health check 0x%X, result 0x%X"
+#define SGP41_MSG_HEALTH_FORCED					"Instance %u: health check overdue, sample slot skipped"
+
+/* Message list, the position of each entry is its binary log ID. Only append
+ * to it, so logs captured with older firmware can still be decoded */
+#define SGP41_LOG_MESSAGES(X) \
+	X(INIT) \
+	X(ADD_DEVICE_FAIL) \
+	X(SELF_TEST) \
+	X(SELF_TEST_ERROR) \
+	X(SELF_TEST_FAIL) \
+	X(SELF_TEST_OK) \
+	X(SERIAL_ERROR) \
+	X(SERIAL) \
+	X(INIT_OK) \
+	X(MEASURE) \
+	X(HEALTH) \
+	X(HEALTH_FORCED)
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef enum {
+#define SGP41_LOG_ID(name) SGP41_LOG_ID_##name,
+	SGP41_LOG_MESSAGES(SGP41_LOG_ID)
+#undef SGP41_LOG_ID
+	SGP41_LOG_ID_MAX
+} sgp41_log_id_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SGP41_LOG_MSGS_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_pool.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Lock-free fixed-size object pools
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "sdkconfig.h"
+
+#ifdef CONFIG_SGP41_POOLS
+
+#include "sgp41_pool.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* The free list head packs the top object, plus 1 so 0 is empty, with a tag
+ * changed on every update so a stale compare-and-swap fails (ABA) */
+#define HEAD_INDEX_MASK								0x0000FFFF
+#define HEAD_TAG_INC									0x00010000
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+SGP41_POOL_DEFINE(sample_pool, sgp41_sample_t, CONFIG_SGP41_SAMPLE_POOL_SIZE);
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that takes an object never handed out before
+ *
+ * @param pool : Pointer to a sgp41_pool_t instance
+ *
+ * @return Index of the object, or pool->capacity if none is left
+ */
+static uint32_t take_fresh(sgp41_pool_t *const pool);
+
+/**
+ * @brief Function that counts an allocated object and updates the high water
+ * mark
+ *
+ * @param pool : Pointer to a sgp41_pool_t instance
+ */
+static void count_used(sgp41_pool_t *const pool);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that takes an object from a pool
+ */
+void *sgp41_pool_alloc(sgp41_pool_t *const pool) {
+	uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+	uint32_t index = pool->capacity;
+
+	/* Pop the free list. A link read while another task recycles the object is
+	 * stale, but then the tag has changed and the swap fails */
+	while ((head & HEAD_INDEX_MASK) != 0) {
+		uint32_t top = (head & HEAD_INDEX_MASK) - 1;
+		uint32_t next = ((head + HEAD_TAG_INC) & ~HEAD_INDEX_MASK) |
+				__atomic_load_n(&pool->links[top], __ATOMIC_RELAXED);
+
+		if (__atomic_compare_exchange_n(&pool->head, &head, next, true,
+				__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+			index = top;
+			break;
+		}
+	}
+
+	/* Otherwise hand out an object never used */
+	if (index == pool->capacity) {
+		index = take_fresh(pool);
+	}
+
+	if (index == pool->capacity) {
+		__atomic_fetch_add(&pool->failures, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	count_used(pool);
+
+	return pool->objects + index * pool->object_size;
+}
+
+/**
+ * @brief Function that returns an object to its pool
+ */
+void sgp41_pool_free(sgp41_pool_t *const pool, void *object) {
+	if (object == NULL) {
+		return;
+	}
+
+	uint32_t index = ((uint8_t *)object - pool->objects) / pool->object_size;
+	uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+	uint32_t next;
+
+	/* Uncount the object first, once pushed another task can take it */
+	__atomic_fetch_sub(&pool->used, 1, __ATOMIC_RELAXED);
+
+	/* Push on the free list */
+	do {
+		__atomic_store_n(&pool->links[index], head & HEAD_INDEX_MASK,
+				__ATOMIC_RELAXED);
+		next = ((head + HEAD_TAG_INC) & ~HEAD_INDEX_MASK) | (index + 1);
+	} while (!__atomic_compare_exchange_n(&pool->head, &head, next, true,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Function that reads the usage statistics of a pool
+ */
+void sgp41_pool_get_stats(const sgp41_pool_t *const pool,
+		                      sgp41_pool_stats_t *const stats) {
+	stats->capacity = pool->capacity;
+	stats->used = __atomic_load_n(&pool->used, __ATOMIC_RELAXED);
+	stats->high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+	stats->failures = __atomic_load_n(&pool->failures, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Function that takes a sample record from the driver pool
+ */
+sgp41_sample_t *sgp41_sample_alloc(void) {
+	return sgp41_pool_alloc(&sample_pool);
+}
+
+/**
+ * @brief Function that returns a sample record to the driver pool
+ */
+void sgp41_sample_free(sgp41_sample_t *sample) {
+	sgp41_pool_free(&sample_pool, sample);
+}
+
+/**
+ * @brief Function that reads the usage statistics of the sample pool
+ */
+void sgp41_sample_pool_get_stats(sgp41_pool_stats_t *const stats) {
+	sgp41_pool_get_stats(&sample_pool, stats);
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that takes an object never handed out before
+ */
+static uint32_t take_fresh(sgp41_pool_t *const pool) {
+	uint32_t fresh = __atomic_load_n(&pool->fresh, __ATOMIC_RELAXED);
+
+	/* Stop at the capacity instead of counting failed attempts */
+	while (fresh < pool->capacity) {
+		if (__atomic_compare_exchange_n(&pool->fresh, &fresh, fresh + 1, true,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			return fresh;
+		}
+	}
+
+	return pool->capacity;
+}
+
+/**
+ * @brief Function that counts an allocated object
+ */
+static void count_used(sgp41_pool_t *const pool) {
+	uint32_t used = __atomic_add_fetch(&pool->used, 1, __ATOMIC_RELAXED);
+	uint32_t high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+
+	while (used > high_water && !__atomic_compare_exchange_n(&pool->high_water,
+			&high_water, used, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
+#endif /* CONFIG_SGP41_POOLS */
+
+/***************************** END OF FILE ************************************/
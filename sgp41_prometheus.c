@@ -0,0 +1,499 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_prometheus.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Prometheus exporter for SGP41 metrics
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sdkconfig.h"
+
+#ifdef CONFIG_SGP41_PROMETHEUS
+
+#include "sgp41_prometheus.h"
+
+#include <inttypes.h>
+
+#include "esp_log.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* Cursor instance before the first one of a family is resolved */
+#define INSTANCE_FIRST								INT32_MAX
+
+_Static_assert(CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE >=
+		SGP41_PROMETHEUS_LINE_LEN_MAX, "the chunk must hold the longest line");
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum {
+	FAMILY_SRAW_VOC = 0,
+	FAMILY_SRAW_NOX,
+	FAMILY_SAMPLE_TIMESTAMP,
+	FAMILY_PIXEL_OK,
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+	FAMILY_PIXEL_FAILURES,
+	FAMILY_PIXEL_STREAK,
+#endif
+#ifdef CONFIG_SGP41_CPU_STATS
+	FAMILY_BUSY_WAIT,
+	FAMILY_I2C_TIME,
+#endif
+#ifdef CONFIG_SGP41_LATENCY_STATS
+	FAMILY_PHASE_DURATION,
+#endif
+	FAMILY_COUNTERS														/* One family per counter descriptor */
+} family_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *TAG = "sgp41_prometheus";
+
+static const char *const pixel_names[SGP41_PIXEL_MAX] = {"voc", "nox"};
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that returns the registered instance a cursor resumes at:
+ * the one with the given id or, if it was released, the next one
+ *
+ * @param id : Id of the instance
+ *
+ * @return Pointer to a sgp41_t instance, NULL if none is left
+ */
+static sgp41_t *instance_at(int32_t id);
+
+/**
+ * @brief Function that writes the HELP and TYPE lines of a metric family
+ *
+ * @param family : Metric family
+ * @param buf    : Pointer to the buffer where the lines are written
+ * @param len    : Space left in the buffer
+ *
+ * @return Number of bytes the lines need, as returned by snprintf()
+ */
+static int render_header(uint16_t family, char *buf, size_t len);
+
+/**
+ * @brief Function that returns how many lines a metric family has per
+ * instance
+ *
+ * @param family : Metric family
+ *
+ * @return Number of lines
+ */
+static uint16_t family_lines(uint16_t family);
+
+/**
+ * @brief Function that writes one sample line of a metric family
+ *
+ * @param family : Metric family
+ * @param me     : Pointer to the sgp41_t instance being rendered
+ * @param line   : Line of the instance
+ * @param buf    : Pointer to the buffer where the line is written
+ * @param len    : Space left in the buffer
+ *
+ * @return Number of bytes the line needs, as returned by snprintf()
+ */
+static int render_line(uint16_t family, const sgp41_t *const me, uint16_t line,
+		                   char *buf, size_t len);
+
+/**
+ * @brief Function that handles a scrape of the metrics endpoint
+ *
+ * @param req : Pointer to the HTTP request
+ *
+ * @return ESP_OK on success
+ */
+static esp_err_t metrics_handler(httpd_req_t *req);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that prepares a cursor to render a new exposition
+ */
+void sgp41_prometheus_begin(sgp41_prometheus_cursor_t *const cursor) {
+	cursor->family = 0;
+	cursor->header_done = false;
+	cursor->instance = INSTANCE_FIRST;
+	cursor->line = 0;
+}
+
+/**
+ * @brief Function that renders the next part of the Prometheus text exposition
+ * of every registered SGP41 instance
+ */
+esp_err_t sgp41_prometheus_render(sgp41_prometheus_cursor_t *const cursor,
+		                              char *buf, size_t len, size_t *written) {
+	if (cursor == NULL || buf == NULL || written == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	size_t counters_len;
+	sgp41_metrics_get_descs(&counters_len);
+
+	uint16_t families = FAMILY_COUNTERS + counters_len;
+	size_t used = 0;
+
+	/* Instances are not released while they are read, the cursor only keeps
+	 * the id of the instance between calls */
+	sgp41_metrics_acquire();
+
+	while (cursor->family < families) {
+		int n;
+
+		if (!cursor->header_done) {
+			/* Every family starts with its HELP and TYPE lines */
+			n = render_header(cursor->family, buf + used, len - used);
+
+			if (n < 0 || (size_t)n >= len - used) {
+				break;
+			}
+
+			used += n;
+			cursor->header_done = true;
+			cursor->instance = INSTANCE_FIRST;
+			cursor->line = 0;
+			continue;
+		}
+
+		sgp41_t *me = instance_at(cursor->instance);
+
+		if (me == NULL) {
+			/* Every instance rendered, move to the next family */
+			cursor->family++;
+			cursor->header_done = false;
+			continue;
+		}
+
+		if (me->id != cursor->instance) {
+			/* First instance of the family, or the one before was released */
+			cursor->instance = me->id;
+			cursor->line = 0;
+		}
+
+		if (cursor->line >= family_lines(cursor->family)) {
+			/* Ids decrease along the registry */
+			cursor->instance = (int32_t)me->id - 1;
+			cursor->line = 0;
+			continue;
+		}
+
+		/* Only keep the line if it fits whole, otherwise retry on next call */
+		n = render_line(cursor->family, me, cursor->line, buf + used, len - used);
+
+		if (n < 0 || (size_t)n >= len - used) {
+			break;
+		}
+
+		used += n;
+		cursor->line++;
+	}
+
+	sgp41_metrics_release();
+
+	/* A line that does not fit in an empty buffer never will */
+	if (used == 0 && cursor->family < families) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	*written = used;
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that registers a GET handler serving the exposition
+ */
+esp_err_t sgp41_prometheus_register(httpd_handle_t server, const char *uri) {
+	if (server == NULL || uri == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	httpd_uri_t metrics_uri = {
+			.uri = uri,
+			.method = HTTP_GET,
+			.handler = metrics_handler,
+			.user_ctx = NULL
+	};
+
+	esp_err_t ret = httpd_register_uri_handler(server, &metrics_uri);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to register %s handler", uri);
+	}
+
+	return ret;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that returns the registered instance a cursor resumes at
+ */
+static sgp41_t *instance_at(int32_t id) {
+	sgp41_t *me = sgp41_metrics_first_instance();
+
+	while (me != NULL && me->id > id) {
+		me = sgp41_metrics_next_instance(me);
+	}
+
+	return me;
+}
+
+/**
+ * @brief Function that writes the HELP and TYPE lines of a metric family
+ */
+static int render_header(uint16_t family, char *buf, size_t len) {
+	const char *name, *help, *type = "gauge";
+
+	switch (family) {
+		case FAMILY_SRAW_VOC:
+			name = "sgp41_sraw_voc";
+			help = "Latest VOC raw signal in ticks";
+			break;
+		case FAMILY_SRAW_NOX:
+			name = "sgp41_sraw_nox";
+			help = "Latest NOx raw signal in ticks";
+			break;
+		case FAMILY_SAMPLE_TIMESTAMP:
+			name = "sgp41_sample_timestamp_us";
+			help = "Monotonic time of the latest sample";
+			break;
+		case FAMILY_PIXEL_OK:
+			name = "sgp41_self_test_pixel_ok";
+			help = "1 if the pixel passed the latest self test";
+			break;
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+		case FAMILY_PIXEL_FAILURES:
+			name = "sgp41_self_test_pixel_failures";
+			help = "Failed self tests of the pixel in the history";
+			break;
+		case FAMILY_PIXEL_STREAK:
+			name = "sgp41_self_test_pixel_streak";
+			help = "Latest self tests the pixel failed in a row";
+			break;
+#endif
+#ifdef CONFIG_SGP41_CPU_STATS
+		case FAMILY_BUSY_WAIT:
+			name = "sgp41_busy_wait_us_total";
+			help = "CPU time spent busy-waiting for the sensor";
+			type = "counter";
+			break;
+		case FAMILY_I2C_TIME:
+			name = "sgp41_i2c_us_total";
+			help = "Time spent in I2C writes and reads";
+			type = "counter";
+			break;
+#endif
+#ifdef CONFIG_SGP41_LATENCY_STATS
+		case FAMILY_PHASE_DURATION:
+			name = "sgp41_phase_duration_us";
+			help = "Duration of each command phase";
+			type = "histogram";
+			break;
+#endif
+		default: {
+			const sgp41_metric_desc_t *desc =
+					&sgp41_metrics_get_descs(NULL)[family - FAMILY_COUNTERS];
+
+			return snprintf(buf, len, "# HELP sgp41_%s_total %s\n"
+					"# TYPE sgp41_%s_total counter\n", desc->name, desc->help,
+					desc->name);
+		}
+	}
+
+	return snprintf(buf, len, "# HELP %s %s\n# TYPE %s %s\n", name, help, name,
+			type);
+}
+
+/**
+ * @brief Function that returns how many lines a metric family has per
+ * instance
+ */
+static uint16_t family_lines(uint16_t family) {
+	switch (family) {
+		case FAMILY_PIXEL_OK:
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+		case FAMILY_PIXEL_FAILURES:
+		case FAMILY_PIXEL_STREAK:
+#endif
+			return SGP41_PIXEL_MAX;
+#ifdef CONFIG_SGP41_CPU_STATS
+		case FAMILY_BUSY_WAIT:
+		case FAMILY_I2C_TIME:
+			return SGP41_CMD_MAX;
+#endif
+#ifdef CONFIG_SGP41_LATENCY_STATS
+		case FAMILY_PHASE_DURATION:
+			/* Buckets plus the sum and count lines of every command phase */
+			return SGP41_CMD_MAX * SGP41_PHASE_MAX * (SGP41_LATENCY_BUCKETS + 2);
+#endif
+		default:
+			return 1;
+	}
+}
+
+/**
+ * @brief Function that writes one sample line of a metric family
+ */
+static int render_line(uint16_t family, const sgp41_t *const me, uint16_t line,
+		                   char *buf, size_t len) {
+	switch (family) {
+		case FAMILY_SRAW_VOC:
+			return snprintf(buf, len, "sgp41_sraw_voc{instance=\"%u\"} %u\n",
+					me->id, me->sraw_voc);
+		case FAMILY_SRAW_NOX:
+			return snprintf(buf, len, "sgp41_sraw_nox{instance=\"%u\"} %u\n",
+					me->id, me->sraw_nox);
+		case FAMILY_SAMPLE_TIMESTAMP:
+			return snprintf(buf, len, "sgp41_sample_timestamp_us{instance=\"%u\"} %"
+					PRId64 "\n", me->id, me->sample_us);
+		case FAMILY_PIXEL_OK:
+			/* No line until the instance has run a self test */
+			if (me->self_test.timestamp_us == 0) {
+				return 0;
+			}
+
+			return snprintf(buf, len, "sgp41_self_test_pixel_ok{instance=\"%u\","
+					"pixel=\"%s\"} %u\n", me->id, pixel_names[line],
+					me->self_test.pixel_ok[line]);
+#ifdef CONFIG_SGP41_SELF_TEST_HISTORY
+		case FAMILY_PIXEL_FAILURES:
+		case FAMILY_PIXEL_STREAK: {
+			sgp41_self_test_trend_t trend;
+			sgp41_self_test_get_trend(me, &trend);
+
+			return snprintf(buf, len, "%s{instance=\"%u\",pixel=\"%s\"} %u\n",
+					family == FAMILY_PIXEL_FAILURES ? "sgp41_self_test_pixel_failures" :
+							"sgp41_self_test_pixel_streak", me->id, pixel_names[line],
+					family == FAMILY_PIXEL_FAILURES ? trend.failures[line] :
+							trend.streak[line]);
+		}
+#endif
+#ifdef CONFIG_SGP41_CPU_STATS
+		case FAMILY_BUSY_WAIT:
+			return snprintf(buf, len, "sgp41_busy_wait_us_total{instance=\"%u\","
+					"cmd=\"%s\"} %" PRIu64 "\n", me->id, sgp41_cmd_name(line),
+					me->cpu.spin_us[line]);
+		case FAMILY_I2C_TIME:
+			return snprintf(buf, len, "sgp41_i2c_us_total{instance=\"%u\","
+					"cmd=\"%s\"} %" PRIu64 "\n", me->id, sgp41_cmd_name(line),
+					me->cpu.i2c_us[line]);
+#endif
+#ifdef CONFIG_SGP41_LATENCY_STATS
+		case FAMILY_PHASE_DURATION: {
+			uint16_t pair = line / (SGP41_LATENCY_BUCKETS + 2);
+			uint16_t index = line % (SGP41_LATENCY_BUCKETS + 2);
+			sgp41_cmd_t cmd = pair / SGP41_PHASE_MAX;
+			sgp41_phase_t phase = pair % SGP41_PHASE_MAX;
+			const sgp41_latency_hist_t *hist = &me->latency.hist[cmd][phase];
+
+			if (index == SGP41_LATENCY_BUCKETS) {
+				return snprintf(buf, len, "sgp41_phase_duration_us_sum{instance=\"%u\","
+						"cmd=\"%s\",phase=\"%s\"} %" PRIu64 "\n", me->id,
+						sgp41_cmd_name(cmd), sgp41_phase_name(phase), hist->sum_us);
+			}
+
+			if (index == SGP41_LATENCY_BUCKETS + 1) {
+				return snprintf(buf, len, "sgp41_phase_duration_us_count{instance=\"%u\","
+						"cmd=\"%s\",phase=\"%s\"} %" PRIu32 "\n", me->id,
+						sgp41_cmd_name(cmd), sgp41_phase_name(phase), hist->count);
+			}
+
+			/* Buckets are cumulative, bucket i ends below 2^(i + 1) us */
+			uint32_t cumulative = 0;
+
+			for (uint16_t i = 0; i <= index; i++) {
+				cumulative += hist->buckets[i];
+			}
+
+			if (index == SGP41_LATENCY_BUCKETS - 1) {
+				return snprintf(buf, len, "sgp41_phase_duration_us_bucket{instance=\"%u\","
+						"cmd=\"%s\",phase=\"%s\",le=\"+Inf\"} %" PRIu32 "\n", me->id,
+						sgp41_cmd_name(cmd), sgp41_phase_name(phase), cumulative);
+			}
+
+			return snprintf(buf, len, "sgp41_phase_duration_us_bucket{instance=\"%u\","
+					"cmd=\"%s\",phase=\"%s\",le=\"%" PRIu32 "\"} %" PRIu32 "\n", me->id,
+					sgp41_cmd_name(cmd), sgp41_phase_name(phase),
+					((uint32_t)2 << index) - 1, cumulative);
+		}
+#endif
+		default:
+			return snprintf(buf, len, "sgp41_%s_total{instance=\"%u\"} %" PRIu32 "\n",
+					sgp41_metrics_get_descs(NULL)[family - FAMILY_COUNTERS].name, me->id,
+					sgp41_metrics_read(me, family - FAMILY_COUNTERS));
+	}
+}
+
+/**
+ * @brief Function that handles a scrape of the metrics endpoint
+ */
+static esp_err_t metrics_handler(httpd_req_t *req) {
+	char chunk[CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE];
+	sgp41_prometheus_cursor_t cursor;
+	size_t chunk_len;
+	bool sent = false;
+
+	httpd_resp_set_type(req, "text/plain; version=0.0.4");
+	sgp41_prometheus_begin(&cursor);
+
+	/* Stream the exposition one chunk at a time */
+	for (;;) {
+		esp_err_t ret = sgp41_prometheus_render(&cursor, chunk, sizeof(chunk),
+				&chunk_len);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Metric line longer than the %d byte chunk",
+					CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE);
+
+			/* Once the status line is out, closing the connection is the only
+			 * way to tell the scraper the exposition is incomplete */
+			return sent ? ESP_FAIL : httpd_resp_send_500(req);
+		}
+
+		if (chunk_len == 0) {
+			break;
+		}
+
+		ret = httpd_resp_send_chunk(req, chunk, chunk_len);
+
+		if (ret != ESP_OK) {
+			return ret;
+		}
+
+		sent = true;
+	}
+
+	/* Terminate the chunked response */
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+#endif /* CONFIG_SGP41_PROMETHEUS */
+
+/***************************** END OF FILE ************************************/
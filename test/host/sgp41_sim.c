@@ -0,0 +1,431 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_sim.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Simulated SGP41 sensors, I2C buses with a mux and a
+  *                   virtual clock for host tests of the driver
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* Written independently of sgp41_codec.h, so the tests cross-check it */
+#define SIM_CRC8_POLYNOMIAL							0x31
+#define SIM_CRC8_INIT										0xFF
+
+/* Self test result with both pixels fine */
+#define SIM_SELF_TEST_OK								0xD400
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	uint16_t opcode;
+	uint8_t args;
+	uint8_t response_words;
+	uint32_t processing_us;
+} sim_command_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Commands of the datasheet, with their maximum processing times */
+static const sim_command_t sim_commands[] = {
+		{0x2612, 2, 1, 50000},										/* Execute conditioning */
+		{0x2619, 2, 2, 50000},										/* Measure raw signals */
+		{0x280E, 0, 1, 320000},										/* Execute self test */
+		{0x3615, 0, 0, 1000},											/* Turn heater off */
+		{0x3682, 0, 3, 1000}											/* Get serial number */
+};
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that computes the CRC-8 of a word
+ *
+ * @param data : Pointer to the two bytes of the word
+ *
+ * @return CRC byte
+ */
+static uint8_t sim_crc(const uint8_t *data);
+
+/**
+ * @brief Function that returns the next value of the raw signals generator
+ *
+ * @param dev : Pointer to a sgp41_sim_device_t instance
+ *
+ * @return Pseudo-random value
+ */
+static uint32_t sim_random(sgp41_sim_device_t *const dev);
+
+/**
+ * @brief Function that receives a command frame
+ *
+ * @param dev  : Pointer to a sgp41_sim_device_t instance
+ * @param data : Pointer to the frame
+ * @param len  : Length of the frame
+ *
+ * @return ESP_OK on success, SGP41_ERR_WRITE_NACK if the frame is refused
+ */
+static esp_err_t sim_device_write(sgp41_sim_device_t *const dev,
+		                              const uint8_t *data, size_t len);
+
+/**
+ * @brief Function that sends the response of the last command
+ *
+ * @param dev  : Pointer to a sgp41_sim_device_t instance
+ * @param data : Pointer where the response is stored
+ * @param len  : Length of the read
+ *
+ * @return ESP_OK on success, SGP41_ERR_READ_NACK if no response is ready
+ */
+static esp_err_t sim_device_read(sgp41_sim_device_t *const dev, uint8_t *data,
+		                             size_t len);
+
+/**
+ * @brief Function that selects the mux channel of a port, if needed, and
+ * returns its sensor
+ *
+ * @param port : Pointer to a sgp41_sim_port_t instance
+ *
+ * @return Pointer to the sensor, NULL if the channel is empty
+ */
+static sgp41_sim_device_t *sim_port_select(sgp41_sim_port_t *const port);
+
+/**
+ * @brief Function that writes a command frame to the sensor of a port
+ *
+ * @param ctx  : Pointer to a sgp41_sim_port_t instance
+ * @param data : Pointer to the frame
+ * @param len  : Length of the frame
+ *
+ * @return ESP_OK on success, SGP41_ERR_WRITE_NACK otherwise
+ */
+static esp_err_t sim_port_write(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Function that reads a response from the sensor of a port
+ *
+ * @param ctx  : Pointer to a sgp41_sim_port_t instance
+ * @param data : Pointer where the response is stored
+ * @param len  : Length of the read
+ *
+ * @return ESP_OK on success, SGP41_ERR_READ_NACK otherwise
+ */
+static esp_err_t sim_port_read(void *ctx, uint8_t *data, size_t len);
+
+/**
+ * @brief Function that returns the time of a virtual clock
+ *
+ * @param ctx : Pointer to a sgp41_sim_clock_t instance
+ *
+ * @return Virtual time in us
+ */
+static int64_t sim_clock_now(void *ctx);
+
+/**
+ * @brief Function that waits on a virtual clock, advancing it instantly
+ *
+ * @param ctx       : Pointer to a sgp41_sim_clock_t instance
+ * @param period_us : Time to wait
+ */
+static void sim_clock_wait(void *ctx, uint32_t period_us);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that initializes a virtual clock
+ */
+void sgp41_sim_clock_init(sgp41_sim_clock_t *const clock, int64_t start_us) {
+	clock->now_us = start_us;
+	clock->hook = (sgp41_clock_t) {
+			.now_us = sim_clock_now,
+			.wait_us = sim_clock_wait,
+			.ctx = clock
+	};
+}
+
+/**
+ * @brief Function that moves a virtual clock forward to a given time
+ */
+void sgp41_sim_clock_advance_to(sgp41_sim_clock_t *const clock,
+		                            int64_t time_us) {
+	if (time_us > clock->now_us) {
+		clock->now_us = time_us;
+	}
+}
+
+/**
+ * @brief Function that initializes a simulated sensor
+ */
+void sgp41_sim_device_init(sgp41_sim_device_t *const dev,
+		                       sgp41_sim_clock_t *clock, uint32_t seed) {
+	*dev = (sgp41_sim_device_t) {
+			.clock = clock,
+			.state = seed,
+			.serial = {(uint16_t)(seed >> 16), (uint16_t)seed, 0x5341},
+			.test_result = SIM_SELF_TEST_OK
+	};
+}
+
+/**
+ * @brief Function that initializes a simulated bus with a mux and no sensors
+ */
+void sgp41_sim_bus_init(sgp41_sim_bus_t *const bus, sgp41_sim_clock_t *clock) {
+	*bus = (sgp41_sim_bus_t) {
+			.clock = clock,
+			.channel = -1
+	};
+}
+
+/**
+ * @brief Function that connects a sensor to a mux channel of a bus
+ */
+const sgp41_transport_t *sgp41_sim_attach(sgp41_sim_port_t *const port,
+		                                      sgp41_sim_bus_t *bus, uint8_t channel,
+																					sgp41_sim_device_t *dev) {
+	bus->devices[channel] = dev;
+
+	*port = (sgp41_sim_port_t) {
+			.bus = bus,
+			.channel = channel,
+			.transport = {
+					.write = sim_port_write,
+					.read = sim_port_read,
+					.ctx = port
+			}
+	};
+
+	return &port->transport;
+}
+
+/**
+ * @brief Function that adds data to a FNV-1a digest
+ */
+uint64_t sgp41_sim_digest(uint64_t digest, const void *data, size_t len) {
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	for (size_t i = 0; i < len; i++) {
+		digest ^= bytes[i];
+		digest *= 0x100000001B3ULL;
+	}
+
+	return digest;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that computes the CRC-8 of a word
+ */
+static uint8_t sim_crc(const uint8_t *data) {
+	uint8_t crc = SIM_CRC8_INIT;
+
+	for (uint8_t i = 0; i < 2; i++) {
+		crc ^= data[i];
+
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ SIM_CRC8_POLYNOMIAL) :
+					(uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * @brief Function that returns the next value of the raw signals generator
+ */
+static uint32_t sim_random(sgp41_sim_device_t *const dev) {
+	dev->state = dev->state * 1664525 + 1013904223;
+
+	return dev->state >> 8;
+}
+
+/**
+ * @brief Function that receives a command frame
+ */
+static esp_err_t sim_device_write(sgp41_sim_device_t *const dev,
+		                              const uint8_t *data, size_t len) {
+	dev->clock->now_us += (len + 1) * SGP41_SIM_BYTE_US;
+	dev->writes++;
+
+	if (dev->nack_fault_period != 0 && dev->writes % dev->nack_fault_period == 0) {
+		return SGP41_ERR_WRITE_NACK;
+	}
+
+	/* A new command always drops the previous response */
+	dev->cmd = 0;
+
+	if (len < 2) {
+		dev->bad_frames++;
+		return SGP41_ERR_WRITE_NACK;
+	}
+
+	uint16_t opcode = (uint16_t)((data[0] << 8) | data[1]);
+	const sim_command_t *command = NULL;
+
+	for (size_t i = 0; i < sizeof(sim_commands) / sizeof(sim_commands[0]); i++) {
+		if (sim_commands[i].opcode == opcode) {
+			command = &sim_commands[i];
+		}
+	}
+
+	if (command == NULL || len != 2 + command->args * 3u) {
+		dev->bad_frames++;
+		return SGP41_ERR_WRITE_NACK;
+	}
+
+	uint16_t args[2] = {0};
+
+	for (uint8_t i = 0; i < command->args; i++) {
+		const uint8_t *word = &data[2 + i * 3];
+
+		if (sim_crc(word) != word[2]) {
+			dev->bad_frames++;
+			return SGP41_ERR_WRITE_NACK;
+		}
+
+		args[i] = (uint16_t)((word[0] << 8) | word[1]);
+	}
+
+	/* Raw signals drift with the compensation, so a wrong argument shows */
+	switch (opcode) {
+		case 0x2612:
+			dev->response[0] = (uint16_t)(26000 + sim_random(dev) % 2000 +
+					(args[0] >> 8));
+			break;
+		case 0x2619:
+			dev->response[0] = (uint16_t)(26000 + sim_random(dev) % 2000 +
+					(args[0] >> 8));
+			dev->response[1] = (uint16_t)(14000 + sim_random(dev) % 1000 +
+					(args[1] >> 8));
+			break;
+		case 0x280E:
+			dev->response[0] = dev->test_result;
+			break;
+		case 0x3682:
+			dev->response[0] = dev->serial[0];
+			dev->response[1] = dev->serial[1];
+			dev->response[2] = dev->serial[2];
+			break;
+		default:
+			break;
+	}
+
+	dev->cmd = command->response_words > 0 ? opcode : 0;
+	dev->response_words = command->response_words;
+	dev->ready_us = dev->clock->now_us + command->processing_us;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that sends the response of the last command
+ */
+static esp_err_t sim_device_read(sgp41_sim_device_t *const dev, uint8_t *data,
+		                             size_t len) {
+	dev->clock->now_us += (len + 1) * SGP41_SIM_BYTE_US;
+	dev->reads++;
+
+	if (dev->cmd == 0 || len > dev->response_words * 3u) {
+		return SGP41_ERR_READ_NACK;
+	}
+
+	/* The sensor does not acknowledge while it is still processing */
+	if (dev->clock->now_us < dev->ready_us) {
+		dev->early_reads++;
+		return SGP41_ERR_READ_NACK;
+	}
+
+	for (size_t i = 0; i < len / 3; i++) {
+		uint8_t *word = &data[i * 3];
+		word[0] = (uint8_t)(dev->response[i] >> 8);
+		word[1] = (uint8_t)(dev->response[i] & 0xFF);
+		word[2] = sim_crc(word);
+	}
+
+	if (dev->crc_fault_period != 0 && dev->reads % dev->crc_fault_period == 0) {
+		data[2] ^= 0x01;
+	}
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that selects the mux channel of a port, if needed
+ */
+static sgp41_sim_device_t *sim_port_select(sgp41_sim_port_t *const port) {
+	sgp41_sim_bus_t *bus = port->bus;
+
+	if (bus->channel != port->channel) {
+		bus->clock->now_us += SGP41_SIM_MUX_SELECT_US;
+		bus->channel = (int8_t)port->channel;
+		bus->selects++;
+	}
+
+	return bus->devices[port->channel];
+}
+
+/**
+ * @brief Function that writes a command frame to the sensor of a port
+ */
+static esp_err_t sim_port_write(void *ctx, const uint8_t *data, size_t len) {
+	sgp41_sim_device_t *dev = sim_port_select((sgp41_sim_port_t *)ctx);
+
+	if (dev == NULL) {
+		return SGP41_ERR_WRITE_NACK;
+	}
+
+	return sim_device_write(dev, data, len);
+}
+
+/**
+ * @brief Function that reads a response from the sensor of a port
+ */
+static esp_err_t sim_port_read(void *ctx, uint8_t *data, size_t len) {
+	sgp41_sim_device_t *dev = sim_port_select((sgp41_sim_port_t *)ctx);
+
+	if (dev == NULL) {
+		return SGP41_ERR_READ_NACK;
+	}
+
+	return sim_device_read(dev, data, len);
+}
+
+/**
+ * @brief Function that returns the time of a virtual clock
+ */
+static int64_t sim_clock_now(void *ctx) {
+	return ((sgp41_sim_clock_t *)ctx)->now_us;
+}
+
+/**
+ * @brief Function that waits on a virtual clock, advancing it instantly
+ */
+static void sim_clock_wait(void *ctx, uint32_t period_us) {
+	((sgp41_sim_clock_t *)ctx)->now_us += period_us;
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,167 @@
+/**
+  ******************************************************************************
+  * @file           : sgp41_sim.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Simulated SGP41 sensors, I2C buses with a mux and a
+  *                   virtual clock for host tests of the driver
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SGP41_SIM_H_
+#define SGP41_SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sgp41.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+/* Channels of the TCA9548A-like mux in front of every bus */
+#define SGP41_SIM_MUX_CHANNELS					8
+
+/* One byte with its acknowledge at 400 kHz, and a mux channel selection */
+#define SGP41_SIM_BYTE_US								23
+#define SGP41_SIM_MUX_SELECT_US					(2 * SGP41_SIM_BYTE_US)
+
+/* FNV-1a offset basis, the first value given to sgp41_sim_digest() */
+#define SGP41_SIM_DIGEST_INIT						0xCBF29CE484222325ULL
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct {
+	int64_t now_us;														/*!< Virtual time */
+	sgp41_clock_t hook;												/*!< Given to sgp41_set_clock() */
+} sgp41_sim_clock_t;
+
+typedef struct {
+	sgp41_sim_clock_t *clock;									/*!< Clock the processing times run on */
+	uint32_t state;														/*!< Generator of the raw signals */
+	uint16_t serial[3];												/*!< Serial number words */
+	uint16_t test_result;											/*!< Self test result */
+	uint16_t cmd;															/*!< Command being answered, 0 if none */
+	int64_t ready_us;													/*!< Time its response is ready */
+	uint16_t response[3];											/*!< Response words */
+	uint8_t response_words;										/*!< Number of response words */
+	uint32_t crc_fault_period;								/*!< Corrupt every nth read, 0 never */
+	uint32_t nack_fault_period;								/*!< Refuse every nth write, 0 never */
+	uint32_t writes;													/*!< Command writes addressed */
+	uint32_t reads;														/*!< Response reads addressed */
+	uint32_t bad_frames;											/*!< Frames with a wrong length or CRC */
+	uint32_t early_reads;											/*!< Reads before the response was ready */
+} sgp41_sim_device_t;
+
+typedef struct {
+	sgp41_sim_clock_t *clock;									/*!< Clock the transfers run on */
+	int8_t channel;														/*!< Selected mux channel, -1 if none */
+	uint32_t selects;													/*!< Mux channel changes */
+	sgp41_sim_device_t *devices[SGP41_SIM_MUX_CHANNELS];	/*!< Sensor per channel */
+} sgp41_sim_bus_t;
+
+typedef struct {
+	sgp41_sim_bus_t *bus;											/*!< Bus the sensor is on */
+	uint8_t channel;													/*!< Mux channel of the sensor */
+	sgp41_transport_t transport;							/*!< Given to sgp41_init_with_transport() */
+} sgp41_sim_port_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function that initializes a virtual clock. Waits of the driver
+ * advance it instantly.
+ *
+ * @param clock    : Pointer to a sgp41_sim_clock_t instance
+ * @param start_us : Initial time
+ */
+void sgp41_sim_clock_init(sgp41_sim_clock_t *const clock, int64_t start_us);
+
+/**
+ * @brief Function that moves a virtual clock forward to a given time, it
+ * never goes back
+ *
+ * @param clock   : Pointer to a sgp41_sim_clock_t instance
+ * @param time_us : Time to reach
+ */
+void sgp41_sim_clock_advance_to(sgp41_sim_clock_t *const clock,
+		                            int64_t time_us);
+
+/**
+ * @brief Function that initializes a simulated sensor. Its raw signals follow
+ * the compensation and a generator seeded with seed, so equal seeds give
+ * equal runs.
+ *
+ * @param dev   : Pointer to a sgp41_sim_device_t instance
+ * @param clock : Pointer to the clock the processing times run on
+ * @param seed  : Seed of the raw signals and the serial number
+ */
+void sgp41_sim_device_init(sgp41_sim_device_t *const dev,
+		                       sgp41_sim_clock_t *clock, uint32_t seed);
+
+/**
+ * @brief Function that initializes a simulated bus with a mux and no sensors
+ *
+ * @param bus   : Pointer to a sgp41_sim_bus_t instance
+ * @param clock : Pointer to the clock the transfers run on
+ */
+void sgp41_sim_bus_init(sgp41_sim_bus_t *const bus, sgp41_sim_clock_t *clock);
+
+/**
+ * @brief Function that connects a sensor to a mux channel of a bus and returns
+ * the transport that reaches it
+ *
+ * @param port    : Pointer to a sgp41_sim_port_t instance, must outlive the
+ *                  driver instance
+ * @param bus     : Pointer to the bus
+ * @param channel : Mux channel
+ * @param dev     : Pointer to the sensor
+ *
+ * @return Pointer to the transport to give to sgp41_init_with_transport()
+ */
+const sgp41_transport_t *sgp41_sim_attach(sgp41_sim_port_t *const port,
+		                                      sgp41_sim_bus_t *bus, uint8_t channel,
+																					sgp41_sim_device_t *dev);
+
+/**
+ * @brief Function that adds data to a FNV-1a digest
+ *
+ * @param digest : Digest so far, SGP41_SIM_DIGEST_INIT for the first data
+ * @param data   : Pointer to the data
+ * @param len    : Length of the data
+ *
+ * @return Updated digest
+ */
+uint64_t sgp41_sim_digest(uint64_t digest, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SGP41_SIM_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file           : esp_http_server.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Host stand-in for the ESP-IDF HTTP server, serving the registered
+  *                   handlers on a loopback TCP socket so tests can scrape them
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef ESP_HTTP_SERVER_H_
+#define ESP_HTTP_SERVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+/* Port 0 picks a free one, see httpd_host_port() */
+#define HTTPD_DEFAULT_CONFIG()					{ \
+		.server_port = 80, \
+		.max_uri_handlers = 8 \
+	}
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct host_httpd_s *httpd_handle_t;
+
+typedef enum {
+	HTTP_GET = 1
+} httpd_method_t;
+
+typedef struct httpd_req {
+	httpd_handle_t handle;
+	int method;
+	const char *uri;
+	void *user_ctx;
+	void *aux;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+	const char *uri;
+	httpd_method_t method;
+	esp_err_t (*handler)(httpd_req_t *r);
+	void *user_ctx;
+} httpd_uri_t;
+
+typedef struct {
+	uint16_t server_port;
+	uint16_t max_uri_handlers;
+} httpd_config_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
+		                                 const httpd_uri_t *uri_handler);
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf,
+		                            ssize_t buf_len);
+esp_err_t httpd_resp_send_500(httpd_req_t *r);
+
+/* Host only: port the server listens on, the one picked for port 0 */
+uint16_t httpd_host_port(httpd_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HTTP_SERVER_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file           : FreeRTOS.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Host stand-in for the FreeRTOS types and port macros
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported Macros -----------------------------------------------------------*/
+#define pdFALSE													0
+#define pdTRUE													1
+#define pdFAIL													pdFALSE
+#define pdPASS													pdTRUE
+
+/* Tick rate of the default ESP-IDF configuration */
+#define configTICK_RATE_HZ							100
+#define portTICK_PERIOD_MS							(1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY										((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)								((TickType_t)(((uint64_t)(ms) * \
+		configTICK_RATE_HZ) / 1000))
+
+/* Every critical section shares one recursive lock */
+#define portMUX_INITIALIZER_UNLOCKED		{0}
+#define portMUX_INITIALIZE(mux)					((mux)->owner = 0)
+#define portENTER_CRITICAL(mux)					vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)					vPortExitCritical(mux)
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+typedef struct {
+	uint32_t owner;
+} portMUX_TYPE;
+
+/* Storage of the host objects, see host_port.c */
+typedef struct {
+	uint64_t storage[24];
+} StaticSemaphore_t;
+
+typedef struct {
+	uint64_t storage[32];
+} StaticTask_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERTOS_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,385 @@
+/**
+  ******************************************************************************
+  * @file           : host_httpd.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : ESP-IDF HTTP server functions used by the Prometheus exporter,
+  *                   implemented on a loopback TCP socket served by a POSIX thread. One
+  *                   request per connection, GET only
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_http_server.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define HTTPD_URI_LEN_MAX								64
+#define HTTPD_REQUEST_LEN_MAX						1024
+#define HTTPD_TYPE_DEFAULT							"text/html"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	char uri[HTTPD_URI_LEN_MAX];
+	httpd_uri_t handler;
+} host_handler_t;
+
+struct host_httpd_s {
+	int listen_fd;
+	uint16_t port;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	host_handler_t *handlers;
+	uint16_t handlers_len;
+	uint16_t handlers_max;
+};
+
+/* State of the response to a request */
+typedef struct {
+	int fd;
+	const char *type;
+	bool started;
+} host_resp_t;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that accepts connections until the server is stopped
+ *
+ * @param arg : Pointer to the server
+ *
+ * @return NULL
+ */
+static void *httpd_serve(void *arg);
+
+/**
+ * @brief Function that reads one request from a connection and answers it
+ *
+ * @param server : Pointer to the server
+ * @param fd     : Connection socket
+ */
+static void httpd_answer(struct host_httpd_s *server, int fd);
+
+/**
+ * @brief Function that writes a whole buffer to a socket
+ *
+ * @param fd   : Socket
+ * @param data : Pointer to the data
+ * @param len  : Length of the data
+ *
+ * @return ESP_OK on success, ESP_FAIL if the peer is gone
+ */
+static esp_err_t httpd_write(int fd, const void *data, size_t len);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that starts a server listening on the loopback interface
+ */
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+	if (handle == NULL || config == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	struct host_httpd_s *server = calloc(1, sizeof(*server));
+
+	if (server == NULL) {
+		return ESP_ERR_NO_MEM;
+	}
+
+	server->handlers = calloc(config->max_uri_handlers, sizeof(host_handler_t));
+	server->handlers_max = config->max_uri_handlers;
+	server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	struct sockaddr_in addr = {
+			.sin_family = AF_INET,
+			.sin_port = htons(config->server_port),
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+	};
+	socklen_t addr_len = sizeof(addr);
+
+	if (server->handlers == NULL || server->listen_fd < 0 ||
+			bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+			listen(server->listen_fd, 4) != 0 ||
+			getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+		if (server->listen_fd >= 0) {
+			close(server->listen_fd);
+		}
+
+		free(server->handlers);
+		free(server);
+
+		return ESP_FAIL;
+	}
+
+	server->port = ntohs(addr.sin_port);
+	pthread_mutex_init(&server->lock, NULL);
+
+	if (pthread_create(&server->thread, NULL, httpd_serve, server) != 0) {
+		close(server->listen_fd);
+		pthread_mutex_destroy(&server->lock);
+		free(server->handlers);
+		free(server);
+
+		return ESP_FAIL;
+	}
+
+	*handle = server;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that stops a server, the request being answered is
+ * finished first
+ */
+esp_err_t httpd_stop(httpd_handle_t handle) {
+	if (handle == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Wakes up accept() in the server thread */
+	shutdown(handle->listen_fd, SHUT_RDWR);
+	pthread_join(handle->thread, NULL);
+	close(handle->listen_fd);
+	pthread_mutex_destroy(&handle->lock);
+	free(handle->handlers);
+	free(handle);
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that registers the handler of a URI
+ */
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
+		                                 const httpd_uri_t *uri_handler) {
+	if (handle == NULL || uri_handler == NULL || uri_handler->uri == NULL ||
+			strlen(uri_handler->uri) >= HTTPD_URI_LEN_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	esp_err_t ret = ESP_ERR_NO_MEM;
+	pthread_mutex_lock(&handle->lock);
+
+	if (handle->handlers_len < handle->handlers_max) {
+		/* The URI is copied, as ESP-IDF does */
+		host_handler_t *entry = &handle->handlers[handle->handlers_len++];
+		strcpy(entry->uri, uri_handler->uri);
+		entry->handler = *uri_handler;
+		entry->handler.uri = entry->uri;
+		ret = ESP_OK;
+	}
+
+	pthread_mutex_unlock(&handle->lock);
+
+	return ret;
+}
+
+/**
+ * @brief Function that sets the content type of a response
+ */
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+	((host_resp_t *)r->aux)->type = type;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that sends a chunk of a chunked response, an empty one ends
+ * it
+ */
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf,
+		                            ssize_t buf_len) {
+	host_resp_t *resp = r->aux;
+	char line[256];
+
+	if (buf == NULL) {
+		buf_len = 0;
+	}
+
+	if (!resp->started) {
+		int n = snprintf(line, sizeof(line), "HTTP/1.1 200 OK\r\nContent-Type: %s"
+				"\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n",
+				resp->type);
+
+		if (httpd_write(resp->fd, line, n) != ESP_OK) {
+			return ESP_FAIL;
+		}
+
+		resp->started = true;
+	}
+
+	int n = snprintf(line, sizeof(line), "%zx\r\n", (size_t)buf_len);
+
+	if (httpd_write(resp->fd, line, n) != ESP_OK ||
+			httpd_write(resp->fd, buf, buf_len) != ESP_OK ||
+			httpd_write(resp->fd, "\r\n", 2) != ESP_OK) {
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that answers with a 500 Internal Server Error
+ */
+esp_err_t httpd_resp_send_500(httpd_req_t *r) {
+	static const char response[] = "HTTP/1.1 500 Internal Server Error\r\n"
+			"Content-Length: 0\r\nConnection: close\r\n\r\n";
+	host_resp_t *resp = r->aux;
+
+	resp->started = true;
+
+	return httpd_write(resp->fd, response, sizeof(response) - 1);
+}
+
+/**
+ * @brief Function that returns the port a server listens on
+ */
+uint16_t httpd_host_port(httpd_handle_t handle) {
+	return handle->port;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that accepts connections until the server is stopped
+ */
+static void *httpd_serve(void *arg) {
+	struct host_httpd_s *server = arg;
+
+	for (;;) {
+		int fd = accept(server->listen_fd, NULL, NULL);
+
+		if (fd < 0) {
+			break;
+		}
+
+		httpd_answer(server, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Function that reads one request from a connection and answers it
+ */
+static void httpd_answer(struct host_httpd_s *server, int fd) {
+	char request[HTTPD_REQUEST_LEN_MAX];
+	size_t request_len = 0;
+
+	/* Only the request line and the headers are read, GET has no body */
+	while (request_len < sizeof(request) - 1) {
+		ssize_t n = recv(fd, request + request_len,
+				sizeof(request) - 1 - request_len, 0);
+
+		if (n <= 0) {
+			return;
+		}
+
+		request_len += n;
+		request[request_len] = '\0';
+
+		if (strstr(request, "\r\n\r\n") != NULL) {
+			break;
+		}
+	}
+
+	char method[8], uri[HTTPD_URI_LEN_MAX];
+
+	if (sscanf(request, "%7s %63s", method, uri) != 2) {
+		return;
+	}
+
+	httpd_uri_t handler = {0};
+	pthread_mutex_lock(&server->lock);
+
+	for (uint16_t i = 0; i < server->handlers_len; i++) {
+		if (strcmp(server->handlers[i].uri, uri) == 0 &&
+				strcmp(method, "GET") == 0 &&
+				server->handlers[i].handler.method == HTTP_GET) {
+			handler = server->handlers[i].handler;
+		}
+	}
+
+	pthread_mutex_unlock(&server->lock);
+
+	if (handler.handler == NULL) {
+		static const char response[] = "HTTP/1.1 404 Not Found\r\n"
+				"Content-Length: 0\r\nConnection: close\r\n\r\n";
+		httpd_write(fd, response, sizeof(response) - 1);
+
+		return;
+	}
+
+	host_resp_t resp = {
+			.fd = fd,
+			.type = HTTPD_TYPE_DEFAULT,
+			.started = false
+	};
+	httpd_req_t req = {
+			.handle = server,
+			.method = HTTP_GET,
+			.uri = uri,
+			.user_ctx = handler.user_ctx,
+			.aux = &resp
+	};
+
+	/* A failed handler closes the connection, as ESP-IDF does */
+	handler.handler(&req);
+}
+
+/**
+ * @brief Function that writes a whole buffer to a socket
+ */
+static esp_err_t httpd_write(int fd, const void *data, size_t len) {
+	const char *p = data;
+
+	while (len > 0) {
+		ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+
+		if (n <= 0) {
+			return ESP_FAIL;
+		}
+
+		p += n;
+		len -= n;
+	}
+
+	return ESP_OK;
+}
+
+/***************************** END OF FILE ************************************/
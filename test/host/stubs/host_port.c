@@ -0,0 +1,635 @@
+/**
+  ******************************************************************************
+  * @file           : host_port.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : ESP-IDF and FreeRTOS functions used by the driver,
+  *                   implemented on POSIX threads so it runs on the host
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Recursive mutex initializer */
+#define _GNU_SOURCE
+
+/* Includes ------------------------------------------------------------------*/
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* Heap reported as available, the host has no fixed heap */
+#define HOST_HEAP_SIZE									(256 * 1024 * 1024)
+
+/* Priority of app_main() in ESP-IDF */
+#define HOST_MAIN_PRIORITY							1
+
+/* Private typedef -----------------------------------------------------------*/
+struct host_semaphore_s {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint32_t count;
+};
+
+struct host_task_s {
+	pthread_t thread;
+	TaskFunction_t function;
+	void *arg;
+	UBaseType_t priority;
+	eTaskState state;
+	bool delete_requested;
+	bool allocated;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+_Static_assert(sizeof(struct host_semaphore_s) <= sizeof(StaticSemaphore_t),
+		"StaticSemaphore_t too small for the host semaphore");
+_Static_assert(sizeof(struct host_task_s) <= sizeof(StaticTask_t),
+		"StaticTask_t too small for the host task");
+
+/* Private variables ---------------------------------------------------------*/
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static struct host_task_s main_task = {
+		.priority = HOST_MAIN_PRIORITY,
+		.state = eRunning
+};
+
+static __thread struct host_task_s *current_task = NULL;
+
+static size_t heap_minimum_free = HOST_HEAP_SIZE;
+static size_t heap_local_minimum_free = HOST_HEAP_SIZE;
+static bool heap_monitoring = false;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that returns the task running the caller
+ *
+ * @return Pointer to the task, the main task outside of created tasks
+ */
+static struct host_task_s *task_self(void);
+
+/**
+ * @brief Function that starts a task on its thread
+ *
+ * @param task        : Pointer to the task storage
+ * @param function    : Task function
+ * @param arg         : Argument of the task function
+ * @param priority    : Task priority
+ *
+ * @return ESP_OK on success, ESP_FAIL if the thread was not created
+ */
+static esp_err_t task_start(struct host_task_s *task, TaskFunction_t function,
+		                        void *arg, UBaseType_t priority);
+
+/**
+ * @brief Function that runs a task function on its thread
+ *
+ * @param arg : Pointer to the task
+ *
+ * @return Never returns
+ */
+static void *task_entry(void *arg);
+
+/**
+ * @brief Function that initializes a semaphore
+ *
+ * @param buffer : Pointer to the semaphore storage
+ * @param count  : Initial count
+ *
+ * @return Semaphore handle
+ */
+static SemaphoreHandle_t semaphore_init(StaticSemaphore_t *buffer,
+		                                    uint32_t count);
+
+/**
+ * @brief Function that returns the monotonic time
+ *
+ * @return Time in us
+ */
+static int64_t monotonic_us(void);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that returns the name of an error code
+ */
+const char *esp_err_to_name(esp_err_t code) {
+	switch (code) {
+		case ESP_OK:
+			return "ESP_OK";
+		case ESP_FAIL:
+			return "ESP_FAIL";
+		case ESP_ERR_NO_MEM:
+			return "ESP_ERR_NO_MEM";
+		case ESP_ERR_INVALID_ARG:
+			return "ESP_ERR_INVALID_ARG";
+		case ESP_ERR_INVALID_STATE:
+			return "ESP_ERR_INVALID_STATE";
+		case ESP_ERR_INVALID_SIZE:
+			return "ESP_ERR_INVALID_SIZE";
+		case ESP_ERR_NOT_FOUND:
+			return "ESP_ERR_NOT_FOUND";
+		case ESP_ERR_NOT_SUPPORTED:
+			return "ESP_ERR_NOT_SUPPORTED";
+		case ESP_ERR_TIMEOUT:
+			return "ESP_ERR_TIMEOUT";
+		case ESP_ERR_INVALID_CRC:
+			return "ESP_ERR_INVALID_CRC";
+		default:
+			return "UNKNOWN ERROR";
+	}
+}
+
+/**
+ * @brief Function that prints a log message
+ */
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+		               ...) {
+	va_list args;
+
+	fprintf(stderr, "%c (%lld) %s: ", "NEWIDV"[level],
+			(long long)(esp_timer_get_time() / 1000), tag);
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+/**
+ * @brief Function that returns the time since the first call
+ */
+int64_t esp_timer_get_time(void) {
+	static int64_t boot_us = 0;
+
+	if (boot_us == 0) {
+		boot_us = monotonic_us();
+	}
+
+	return monotonic_us() - boot_us;
+}
+
+/**
+ * @brief Function that returns the heap still available
+ */
+size_t heap_caps_get_free_size(uint32_t caps) {
+	struct mallinfo2 info = mallinfo2();
+	size_t free_size = info.uordblks < HOST_HEAP_SIZE ?
+			HOST_HEAP_SIZE - info.uordblks : 0;
+
+	if (free_size < heap_minimum_free) {
+		heap_minimum_free = free_size;
+	}
+
+	if (free_size < heap_local_minimum_free) {
+		heap_local_minimum_free = free_size;
+	}
+
+	return free_size;
+}
+
+/**
+ * @brief Function that returns the lowest heap seen available, since the
+ * start or since the local monitoring started
+ */
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+	heap_caps_get_free_size(caps);
+
+	return heap_monitoring ? heap_local_minimum_free : heap_minimum_free;
+}
+
+/**
+ * @brief Function that starts tracking the lowest heap available from now on
+ */
+esp_err_t heap_caps_monitor_local_minimum_free_size_start(void) {
+	heap_local_minimum_free = HOST_HEAP_SIZE;
+	heap_monitoring = true;
+	heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that goes back to the lowest heap available since the start
+ */
+esp_err_t heap_caps_monitor_local_minimum_free_size_stop(void) {
+	heap_monitoring = false;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that enters a critical section
+ */
+void vPortEnterCritical(portMUX_TYPE *mux) {
+	pthread_mutex_lock(&critical_lock);
+}
+
+/**
+ * @brief Function that exits a critical section
+ */
+void vPortExitCritical(portMUX_TYPE *mux) {
+	pthread_mutex_unlock(&critical_lock);
+}
+
+/**
+ * @brief Function that creates a task with allocated storage
+ */
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name,
+		                   uint32_t stack_depth, void *arg, UBaseType_t priority,
+											 TaskHandle_t *created_task) {
+	struct host_task_s *me = calloc(1, sizeof(struct host_task_s));
+
+	if (me == NULL) {
+		return pdFAIL;
+	}
+
+	me->allocated = true;
+
+	if (task_start(me, task, arg, priority) != ESP_OK) {
+		free(me);
+		return pdFAIL;
+	}
+
+	if (created_task != NULL) {
+		*created_task = me;
+	}
+
+	return pdPASS;
+}
+
+/**
+ * @brief Function that creates a task in the storage given
+ */
+TaskHandle_t xTaskCreateStatic(TaskFunction_t task, const char *name,
+		                           uint32_t stack_depth, void *arg,
+															 UBaseType_t priority, StackType_t *stack,
+															 StaticTask_t *task_buffer) {
+	struct host_task_s *me = (struct host_task_s *)task_buffer;
+
+	*me = (struct host_task_s) {0};
+
+	return task_start(me, task, arg, priority) == ESP_OK ? me : NULL;
+}
+
+/**
+ * @brief Function that deletes a task. Threads cannot be stopped from outside,
+ * so another task can only be deleted while it is suspended
+ */
+void vTaskDelete(TaskHandle_t task) {
+	struct host_task_s *me = task != NULL ? task : task_self();
+
+	if (me == task_self()) {
+		pthread_mutex_lock(&me->lock);
+		me->state = eDeleted;
+		pthread_mutex_unlock(&me->lock);
+		pthread_detach(me->thread);
+		pthread_exit(NULL);
+	}
+
+	pthread_mutex_lock(&me->lock);
+
+	if (me->state != eSuspended) {
+		fprintf(stderr, "vTaskDelete: the host deletes only suspended tasks\n");
+		abort();
+	}
+
+	me->delete_requested = true;
+	pthread_cond_broadcast(&me->cond);
+	pthread_mutex_unlock(&me->lock);
+	pthread_join(me->thread, NULL);
+	me->state = eDeleted;
+
+	if (me->allocated) {
+		free(me);
+	}
+}
+
+/**
+ * @brief Function that suspends the calling task until it is deleted
+ */
+void vTaskSuspend(TaskHandle_t task) {
+	struct host_task_s *me = task_self();
+
+	if (task != NULL && task != me) {
+		fprintf(stderr, "vTaskSuspend: the host suspends only the caller\n");
+		abort();
+	}
+
+	pthread_mutex_lock(&me->lock);
+	me->state = eSuspended;
+
+	while (!me->delete_requested) {
+		pthread_cond_wait(&me->cond, &me->lock);
+	}
+
+	pthread_mutex_unlock(&me->lock);
+	pthread_exit(NULL);
+}
+
+/**
+ * @brief Function that returns the state of a task
+ */
+eTaskState eTaskGetState(TaskHandle_t task) {
+	pthread_mutex_lock(&task->lock);
+	eTaskState state = task->state;
+	pthread_mutex_unlock(&task->lock);
+
+	return state;
+}
+
+/**
+ * @brief Function that blocks the calling task for a number of ticks
+ */
+void vTaskDelay(TickType_t ticks) {
+	int64_t period_us = (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+	struct timespec period = {
+			.tv_sec = period_us / 1000000,
+			.tv_nsec = (period_us % 1000000) * 1000
+	};
+
+	nanosleep(&period, NULL);
+}
+
+/**
+ * @brief Function that blocks the calling task until a fixed wake time
+ */
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+	*previous_wake += increment;
+	TickType_t now = xTaskGetTickCount();
+
+	if ((int32_t)(*previous_wake - now) <= 0) {
+		return pdFALSE;
+	}
+
+	vTaskDelay(*previous_wake - now);
+
+	return pdTRUE;
+}
+
+/**
+ * @brief Function that returns the ticks since the first call
+ */
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t)(esp_timer_get_time() / (portTICK_PERIOD_MS * 1000));
+}
+
+/**
+ * @brief Function that returns the priority of a task
+ */
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+	return (task != NULL ? task : task_self())->priority;
+}
+
+/**
+ * @brief Function that changes the priority of a task
+ */
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+	(task != NULL ? task : task_self())->priority = priority;
+}
+
+/**
+ * @brief Function that creates a binary semaphore, initially empty
+ */
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer) {
+	return semaphore_init(buffer, 0);
+}
+
+/**
+ * @brief Function that creates a mutex, initially free
+ */
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer) {
+	return semaphore_init(buffer, 1);
+}
+
+/**
+ * @brief Function that takes a semaphore, waiting up to a number of ticks
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+	int64_t deadline_us = esp_timer_get_time() +
+			(int64_t)ticks * portTICK_PERIOD_MS * 1000;
+	BaseType_t ret = pdPASS;
+
+	pthread_mutex_lock(&semaphore->lock);
+
+	while (semaphore->count == 0) {
+		if (ticks == 0) {
+			ret = pdFAIL;
+			break;
+		}
+
+		if (ticks == portMAX_DELAY) {
+			pthread_cond_wait(&semaphore->cond, &semaphore->lock);
+			continue;
+		}
+
+		int64_t wait_us = deadline_us - esp_timer_get_time();
+
+		if (wait_us <= 0) {
+			ret = pdFAIL;
+			break;
+		}
+
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_sec += wait_us / 1000000;
+		until.tv_nsec += (wait_us % 1000000) * 1000;
+
+		if (until.tv_nsec >= 1000000000) {
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000;
+		}
+
+		pthread_cond_timedwait(&semaphore->cond, &semaphore->lock, &until);
+	}
+
+	if (ret == pdPASS) {
+		semaphore->count--;
+	}
+
+	pthread_mutex_unlock(&semaphore->lock);
+
+	return ret;
+}
+
+/**
+ * @brief Function that gives a semaphore
+ */
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+	BaseType_t ret = pdFAIL;
+
+	pthread_mutex_lock(&semaphore->lock);
+
+	if (semaphore->count == 0) {
+		semaphore->count = 1;
+		pthread_cond_signal(&semaphore->cond);
+		ret = pdPASS;
+	}
+
+	pthread_mutex_unlock(&semaphore->lock);
+
+	return ret;
+}
+
+/**
+ * @brief Function that deletes a semaphore
+ */
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+	/* configASSERT() in FreeRTOS */
+	if (semaphore == NULL) {
+		fprintf(stderr, "vSemaphoreDelete: NULL semaphore\n");
+		abort();
+	}
+
+	pthread_cond_destroy(&semaphore->cond);
+	pthread_mutex_destroy(&semaphore->lock);
+}
+
+/**
+ * @brief Function that adds a device to a bus, there are no buses on the host
+ */
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle,
+		                                const i2c_device_config_t *dev_config,
+																		i2c_master_dev_handle_t *ret_handle) {
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief Function that removes a device from a bus
+ */
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle) {
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that writes to a device, there are no buses on the host
+ */
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev,
+		                          const uint8_t *write_buffer, size_t write_size,
+															int xfer_timeout_ms) {
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief Function that reads from a device, there are no buses on the host
+ */
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev,
+		                         uint8_t *read_buffer, size_t read_size,
+														 int xfer_timeout_ms) {
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief Function that probes an address, nothing answers on the host
+ */
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address,
+		                       int xfer_timeout_ms) {
+	return ESP_ERR_NOT_FOUND;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that returns the task running the caller
+ */
+static struct host_task_s *task_self(void) {
+	return current_task != NULL ? current_task : &main_task;
+}
+
+/**
+ * @brief Function that starts a task on its thread
+ */
+static esp_err_t task_start(struct host_task_s *task, TaskFunction_t function,
+		                        void *arg, UBaseType_t priority) {
+	task->function = function;
+	task->arg = arg;
+	task->priority = priority;
+	task->state = eReady;
+	pthread_mutex_init(&task->lock, NULL);
+	pthread_cond_init(&task->cond, NULL);
+
+	if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that runs a task function on its thread
+ */
+static void *task_entry(void *arg) {
+	struct host_task_s *task = (struct host_task_s *)arg;
+
+	current_task = task;
+	pthread_mutex_lock(&task->lock);
+	task->state = eRunning;
+	pthread_mutex_unlock(&task->lock);
+
+	task->function(task->arg);
+
+	/* FreeRTOS tasks must delete themselves instead of returning */
+	fprintf(stderr, "task returned without deleting itself\n");
+	abort();
+}
+
+/**
+ * @brief Function that initializes a semaphore
+ */
+static SemaphoreHandle_t semaphore_init(StaticSemaphore_t *buffer,
+		                                    uint32_t count) {
+	SemaphoreHandle_t semaphore = (SemaphoreHandle_t)buffer;
+
+	pthread_mutex_init(&semaphore->lock, NULL);
+	pthread_cond_init(&semaphore->cond, NULL);
+	semaphore->count = count;
+
+	return semaphore;
+}
+
+/**
+ * @brief Function that returns the monotonic time
+ */
+static int64_t monotonic_us(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/***************************** END OF FILE ************************************/
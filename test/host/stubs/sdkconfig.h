@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file           : sdkconfig.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Host values of the integer options of the driver, the
+  *                   boolean options are set per target in CMakeLists.txt
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SDKCONFIG_H_
+#define SDKCONFIG_H_
+
+/* Exported Macros -----------------------------------------------------------*/
+/* Kconfig defaults, except the log level: only errors, so long runs with
+ * injected faults stay readable */
+#define CONFIG_SGP41_LOG_LEVEL								1
+#define CONFIG_SGP41_I2C_TIMEOUT_MS						100
+#define CONFIG_SGP41_HEATER_WARM_UP_MS				10000
+#define CONFIG_SGP41_HEATER_CONDITIONING_MS		10000
+#define CONFIG_SGP41_HEATER_IDLE_TIMEOUT_S		300
+#define CONFIG_SGP41_HEATER_ON_CURRENT_UA			3000
+#define CONFIG_SGP41_HEATER_IDLE_CURRENT_UA		34
+#define CONFIG_SGP41_HEATER_SUPPLY_MV					3300
+#define CONFIG_SGP41_SELF_TEST_HISTORY_SIZE		32
+#define CONFIG_SGP41_CRC_RETRY_MAX						2
+#define CONFIG_SGP41_CRC_RETRY_BUDGET_MS			120
+#define CONFIG_SGP41_HEALTH_PERIOD_S					3600
+#define CONFIG_SGP41_HEALTH_MAX_DELAY_S				600
+#define CONFIG_SGP41_HEALTH_HISTORY_SIZE			16
+#define CONFIG_SGP41_SAMPLE_POOL_SIZE					32
+#define CONFIG_SGP41_BINARY_LOG_RING_SIZE			128
+#define CONFIG_SGP41_TRACE_RING_SIZE					256
+#define CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE		512
+
+#endif /* SDKCONFIG_H_ */
+
+/***************************** END OF FILE ************************************/
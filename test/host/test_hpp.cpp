@@ -0,0 +1,310 @@
+/**
+  ******************************************************************************
+  * @file           : test_hpp.cpp
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : sgp41.hpp on the host: the Driver template against the C driver
+  *                   on simulated sensors, and the RAII Sensor with its chrono API
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <cinttypes>
+#include <cstdio>
+#include <utility>
+
+#include "sgp41.hpp"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define HPP_START_US										1000000
+#define HPP_SEED												0x4000u
+#define HPP_SAMPLES											16
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t sim_clock;
+static int failed = 0;
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief Transport policy over a simulated sensor
+ */
+struct SimTransport {
+	const sgp41_transport_t *transport;
+
+	sgp41::status_t write(const uint8_t *data, size_t len) {
+		return transport->write(transport->ctx, data, len);
+	}
+
+	sgp41::status_t read(uint8_t *data, size_t len) {
+		return transport->read(transport->ctx, data, len);
+	}
+};
+
+/**
+ * @brief Clock policy over the virtual clock
+ */
+struct SimClock {
+	static int64_t now_us() {
+		return sim_clock.now_us;
+	}
+};
+
+/**
+ * @brief Wait policy that advances the virtual sim_clock, as the C driver does
+ * with the clock hook
+ */
+struct SimWait {
+	template <typename Clock>
+	static void wait(std::chrono::microseconds period) {
+		sim_clock.hook.wait_us(sim_clock.hook.ctx, (uint32_t)period.count());
+	}
+};
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that records a failed check
+ *
+ * @param ok   : Result of the check
+ * @param what : Description of the check
+ */
+static void hpp_check(bool ok, const char *what);
+
+/**
+ * @brief Function that measures a simulated sensor with the Driver template
+ * and an equal one with the C driver, and compares every result
+ *
+ * @param name : Name of the CRC policy, for the messages
+ */
+template <typename Crc>
+static void hpp_driver_matches_c(const char *name);
+
+/**
+ * @brief Function that checks the Sensor failure paths: the instance is
+ * released once, and nothing stays registered
+ */
+static void hpp_sensor_failures(void);
+
+/**
+ * @brief Function that checks the Sensor results and its chrono API
+ */
+static void hpp_sensor_chrono(void);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&sim_clock, HPP_START_US);
+	sgp41_set_clock(&sim_clock.hook);
+
+	hpp_driver_matches_c<sgp41::BitwiseCrc>("bitwise");
+	hpp_driver_matches_c<sgp41::TableCrc>("table");
+	hpp_sensor_failures();
+	hpp_sensor_chrono();
+
+	sgp41_set_clock(NULL);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that records a failed check
+ */
+static void hpp_check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		failed = 1;
+	}
+}
+
+/**
+ * @brief Function that compares the Driver template with the C driver
+ */
+template <typename Crc>
+static void hpp_driver_matches_c(const char *name) {
+	sgp41_sim_bus_t bus;
+	sgp41_sim_device_t devs[2];
+	sgp41_sim_port_t ports[2];
+	sgp41_t c_sensor;
+
+	sgp41_sim_bus_init(&bus, &sim_clock);
+	sgp41_sim_device_init(&devs[0], &sim_clock, HPP_SEED);
+	sgp41_sim_device_init(&devs[1], &sim_clock, HPP_SEED);
+
+	sgp41::Driver<SimTransport, SimClock, SimWait, Crc> driver{
+			SimTransport{sgp41_sim_attach(&ports[0], &bus, 0, &devs[0])}};
+
+	if (sgp41_init_with_transport(&c_sensor,
+			sgp41_sim_attach(&ports[1], &bus, 1, &devs[1])) != ESP_OK) {
+		printf("FAIL: %s, C driver init\n", name);
+		failed = 1;
+		return;
+	}
+
+	uint16_t serial[3], c_serial[3], test_result, c_test_result;
+	hpp_check(driver.get_serial_number(serial) == sgp41::ok &&
+			sgp41_get_serial_number(&c_sensor, c_serial) == ESP_OK &&
+			serial[0] == c_serial[0] && serial[1] == c_serial[1] &&
+			serial[2] == c_serial[2], "serial numbers differ");
+	hpp_check(driver.execute_self_test(&test_result) == sgp41::ok &&
+			sgp41_execute_self_test(&c_sensor, &c_test_result) == ESP_OK &&
+			test_result == c_test_result, "self test results differ");
+
+	/* Default compensation goes through the frame built at compile time */
+	for (uint8_t i = 0; i < HPP_SAMPLES; i++) {
+		uint16_t rh = i % 2 ? sgp41::default_rh : (uint16_t)(0x4000 + i * 0x100);
+		uint16_t t = i % 2 ? sgp41::default_t : (uint16_t)(0x6000 + i * 0x10);
+		uint16_t voc = 0, nox = 0, c_voc = 0, c_nox = 0;
+
+		sgp41::status_t ret = driver.measure_raw_signals(rh, t, &voc, &nox);
+		esp_err_t c_ret = sgp41_measure_raw_signals(&c_sensor, rh, t, &c_voc,
+				&c_nox);
+
+		if (ret != sgp41::ok || c_ret != ESP_OK || voc != c_voc || nox != c_nox) {
+			printf("FAIL: %s, sample %u differs\n", name, i);
+			failed = 1;
+		}
+	}
+
+	uint16_t sraw_voc;
+	hpp_check(driver.execute_conditioning(sgp41::default_rh, sgp41::default_t,
+			&sraw_voc) == sgp41::ok && driver.turn_heater_off() == sgp41::ok,
+			"conditioning or heater off failed");
+
+	/* A corrupted response is reported as the C driver does */
+	devs[0].crc_fault_period = 1;
+	devs[1].crc_fault_period = 1;
+	uint16_t voc, nox;
+	sgp41::status_t ret = driver.measure_raw_signals(sgp41::default_rh,
+			sgp41::default_t, &voc, &nox);
+	hpp_check(ret == sgp41::invalid_crc, "CRC error not reported");
+
+	/* The frames reached the sensors intact and never too early */
+	hpp_check(devs[0].bad_frames == 0 && devs[0].early_reads == 0 &&
+			devs[1].bad_frames == 0 && devs[1].early_reads == 0,
+			"bad frames or early reads");
+
+	sgp41_deinit(&c_sensor);
+}
+
+/**
+ * @brief Function that checks the Sensor failure paths
+ */
+static void hpp_sensor_failures(void) {
+	/* The host has no I2C master, adding the device fails */
+	auto on_bus = sgp41::Sensor::open(nullptr, SGP41_I2C_ADDR);
+	hpp_check(!on_bus.has_value(), "open on a bus succeeded on the host");
+
+	/* A sensor that refuses every command fails in instance_start(), after
+	 * the C driver released the instance itself */
+	sgp41_sim_bus_t bus;
+	sgp41_sim_device_t dev;
+	sgp41_sim_port_t port;
+
+	sgp41_sim_bus_init(&bus, &sim_clock);
+	sgp41_sim_device_init(&dev, &sim_clock, HPP_SEED);
+	dev.nack_fault_period = 1;
+
+	auto refused = sgp41::Sensor::open(sgp41_sim_attach(&port, &bus, 0, &dev));
+	hpp_check(!refused.has_value() &&
+			refused.error() == sgp41::Error::write_nack, "NACK not reported");
+
+	/* Releasing twice is harmless */
+	sgp41_t me;
+	dev.nack_fault_period = 0;
+	hpp_check(sgp41_init_with_transport(&me, &port.transport) == ESP_OK &&
+			sgp41_deinit(&me) == ESP_OK && sgp41_deinit(&me) == ESP_OK,
+			"second sgp41_deinit() failed");
+
+	hpp_check(sgp41_metrics_first_instance() == NULL,
+			"instance left registered");
+}
+
+/**
+ * @brief Function that checks the Sensor results and its chrono API
+ */
+static void hpp_sensor_chrono(void) {
+	using namespace std::chrono_literals;
+
+	sgp41_sim_bus_t bus;
+	sgp41_sim_device_t dev;
+	sgp41_sim_port_t port;
+
+	sgp41_sim_bus_init(&bus, &sim_clock);
+	sgp41_sim_device_init(&dev, &sim_clock, HPP_SEED);
+
+	{
+		auto opened = sgp41::Sensor::open(sgp41_sim_attach(&port, &bus, 0, &dev));
+
+		if (!opened) {
+			printf("FAIL: open, %s\n",
+					esp_err_to_name(static_cast<esp_err_t>(opened.error())));
+			failed = 1;
+			return;
+		}
+
+		/* Ownership moves, the instance is released once */
+		sgp41::Sensor sensor = std::move(*opened);
+		hpp_check(sgp41_metrics_first_instance() == sensor.native(),
+				"sensor not registered");
+
+		auto serial = sensor.serial_number();
+		hpp_check(serial && *serial == (((uint64_t)dev.serial[0] << 32) |
+				((uint64_t)dev.serial[1] << 16) | dev.serial[2]), "wrong serial");
+
+		auto sample = sensor.measure();
+		hpp_check(sample && sample->seq == 0 &&
+				sample->timestamp == std::chrono::microseconds{sim_clock.now_us} &&
+				(sample->flags & sgp41::sample_uncompensated),
+				"wrong measured sample");
+
+		/* A recent sample is shared, an old one is measured again */
+		auto fresh = sensor.latest(1s);
+		auto shared = sensor.latest(1s);
+		hpp_check(fresh && shared && shared->seq == fresh->seq,
+				"recent sample not shared");
+
+		sgp41_sim_clock_advance_to(&sim_clock, sim_clock.now_us + 2000000);
+		auto renewed = sensor.latest(1s);
+		hpp_check(renewed && renewed->seq == fresh->seq + 1,
+				"old sample not measured again");
+
+		/* A due check runs in a gap long enough for the self test only */
+		sgp41_sim_clock_advance_to(&sim_clock, sim_clock.now_us +
+				CONFIG_SGP41_HEALTH_PERIOD_S * 1000000LL);
+		auto skipped = sensor.health_poll(100ms);
+		auto ran = sensor.health_poll(1s);
+		hpp_check(skipped && !*skipped && ran && *ran,
+				"health check not run in the right gap");
+	}
+
+	hpp_check(sgp41_metrics_first_instance() == NULL,
+			"sensor not released on destruction");
+}
+
+/***************************** END OF FILE ************************************/
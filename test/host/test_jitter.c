@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * @file           : test_jitter.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : sgp41_benchmark_jitter() on a simulated sensor and the virtual
+  *                   clock, with every wait strategy and scheduling mode
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "sgp41.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define JITTER_START_US									1000000
+#define JITTER_PERIOD_MS								100
+#define JITTER_SAMPLES									32
+#define JITTER_DEADLINE_US							1000
+#define JITTER_DUTY_PCT									25
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t bus;
+static sgp41_sim_device_t dev;
+static sgp41_sim_port_t port;
+static sgp41_t sensor;
+
+/* Probed by the bus load task, the host bus answers no probe */
+static uint8_t load_bus_storage;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that runs the benchmark into a string
+ *
+ * @param config : Pointer to the scenario
+ * @param output : Pointer where the output is stored, to be freed
+ *
+ * @return Result of the benchmark
+ */
+static esp_err_t jitter_run(const sgp41_jitter_config_t *config, char **output);
+
+/**
+ * @brief Function that finds the result line of a combination
+ *
+ * @param output   : Pointer to the output of the benchmark
+ * @param wait     : Wait strategy name
+ * @param schedule : Scheduling mode name
+ *
+ * @return Pointer to the line, NULL if there is none
+ */
+static const char *jitter_line(const char *output, const char *wait,
+		                           const char *schedule);
+
+/**
+ * @brief Function that returns an integer field of a JSON line
+ *
+ * @param line : Pointer to the line
+ * @param name : Field name
+ *
+ * @return Field value, -1 if the line has no such field
+ */
+static int64_t jitter_field(const char *line, const char *name);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, JITTER_START_US);
+	sgp41_set_clock(&clock.hook);
+	sgp41_sim_bus_init(&bus, &clock);
+	sgp41_sim_device_init(&dev, &clock, 0x3000u);
+
+	esp_err_t ret = sgp41_init_with_transport(&sensor,
+			sgp41_sim_attach(&port, &bus, 0, &dev));
+
+	if (ret != ESP_OK) {
+		printf("FAIL: init, %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	int failed = 0;
+
+	if (sgp41_set_wait(&sensor, SGP41_WAIT_MAX) != ESP_ERR_INVALID_ARG ||
+			sgp41_set_wait(&sensor, SGP41_WAIT_BUSY) != ESP_OK) {
+		printf("FAIL: wait strategy not validated\n");
+		failed = 1;
+	}
+
+	/* Virtual time of one measurement waiting exactly the processing time */
+	uint16_t sraw_voc, sraw_nox;
+	int64_t start_us = clock.now_us;
+	sgp41_measure_raw_signals(&sensor, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+			&sraw_voc, &sraw_nox);
+	int64_t measure_us = clock.now_us - start_us;
+	int64_t tick_us = portTICK_PERIOD_MS * 1000;
+	sgp41_set_wait(&sensor, SGP41_WAIT_TASK_DELAY);
+
+	sgp41_jitter_config_t config = {
+			.period_ms = JITTER_PERIOD_MS,
+			.samples = JITTER_SAMPLES,
+			.deadline_us = JITTER_DEADLINE_US,
+			.cpu_load = true,
+			.load_bus = (i2c_master_bus_handle_t)&load_bus_storage,
+			.load_addr = SGP41_I2C_ADDR,
+			.load_duty_pct = JITTER_DUTY_PCT
+	};
+	sgp41_jitter_config_t over_duty = config;
+	over_duty.load_duty_pct = 101;
+	char *output, *again;
+
+	if (sgp41_benchmark_jitter(&sensor, &over_duty, stdout) !=
+			ESP_ERR_INVALID_ARG) {
+		printf("FAIL: duty cycle above 100 %% accepted\n");
+		failed = 1;
+	}
+
+	ret = jitter_run(&config, &output);
+	fputs(output, stdout);
+
+	if (ret != ESP_OK || jitter_run(&config, &again) != ESP_OK) {
+		printf("FAIL: %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	/* The virtual clock paces the loop, so every run gives the same output */
+	if (strcmp(output, again) != 0) {
+		printf("FAIL: runs differ\n");
+		failed = 1;
+	}
+
+	static const char *const waits[] = {"busy", "task_delay"};
+	int64_t longest_us[2][2];
+
+	for (uint8_t i = 0; i < sizeof(waits) / sizeof(waits[0]); i++) {
+		const char *relative = jitter_line(output, waits[i], "relative");
+		const char *absolute = jitter_line(output, waits[i], "absolute");
+
+		if (relative == NULL || absolute == NULL) {
+			printf("FAIL: %s wait not run with both schedules\n", waits[i]);
+			failed = 1;
+			continue;
+		}
+
+		/* Without load both schedules wake up on every period, the relative one
+		 * counting the measurement in its delay */
+		if (jitter_field(relative, "max_us") != 0 ||
+				jitter_field(relative, "deadline_misses") != 0 ||
+				jitter_field(absolute, "max_us") != 0 ||
+				jitter_field(absolute, "deadline_misses") != 0) {
+			printf("FAIL: %s wait, periods off without load\n", waits[i]);
+			failed = 1;
+		}
+
+		longest_us[i][0] = jitter_field(relative, "measure_max_us");
+		longest_us[i][1] = jitter_field(absolute, "measure_max_us");
+
+		if (jitter_field(relative, "errors") != 0 ||
+				jitter_field(absolute, "errors") != 0 ||
+				jitter_field(relative, "bus_duty_pct") != JITTER_DUTY_PCT ||
+				strstr(relative, "\"cpu_load\":true,\"bus_load\":true") == NULL) {
+			printf("FAIL: %s wait, errors or load not reported\n", waits[i]);
+			failed = 1;
+		}
+	}
+
+	/* Spinning takes the processing time, blocking ends on a later tick */
+	for (uint8_t i = 0; i < 2; i++) {
+		if (longest_us[0][i] != measure_us || longest_us[1][i] <= measure_us ||
+				longest_us[1][i] > measure_us + 2 * tick_us) {
+			printf("FAIL: measurements of %" PRId64 " us spinning and %" PRId64
+					" us blocking, expected %" PRId64 " us and up to 2 ticks more\n",
+					longest_us[0][i], longest_us[1][i], measure_us);
+			failed = 1;
+		}
+	}
+
+	/* The instance keeps the strategy it was given */
+	if (sensor.wait != SGP41_WAIT_TASK_DELAY) {
+		printf("FAIL: wait strategy not restored\n");
+		failed = 1;
+	}
+
+	if (dev.bad_frames != 0 || dev.early_reads != 0) {
+		printf("FAIL: %" PRIu32 " bad frames and %" PRIu32 " early reads\n",
+				dev.bad_frames, dev.early_reads);
+		failed = 1;
+	}
+
+	sgp41_deinit(&sensor);
+	sgp41_set_clock(NULL);
+	free(output);
+	free(again);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that runs the benchmark into a string
+ */
+static esp_err_t jitter_run(const sgp41_jitter_config_t *config, char **output) {
+	size_t output_len;
+	FILE *stream = open_memstream(output, &output_len);
+	esp_err_t ret = sgp41_benchmark_jitter(&sensor, config, stream);
+	fclose(stream);
+
+	return ret;
+}
+
+/**
+ * @brief Function that finds the result line of a combination
+ */
+static const char *jitter_line(const char *output, const char *wait,
+		                           const char *schedule) {
+	char key[96];
+	snprintf(key, sizeof(key), "\"wait\":\"%s\",\"schedule\":\"%s\",", wait,
+			schedule);
+
+	return strstr(output, key);
+}
+
+/**
+ * @brief Function that returns an integer field of a JSON line
+ */
+static int64_t jitter_field(const char *line, const char *name) {
+	char key[64];
+	snprintf(key, sizeof(key), "\"%s\":", name);
+
+	const char *end = strchr(line, '\n');
+	const char *field = strstr(line, key);
+
+	if (field == NULL || (end != NULL && field > end)) {
+		return -1;
+	}
+
+	return strtoll(field + strlen(key), NULL, 10);
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,346 @@
+/**
+  ******************************************************************************
+  * @file           : test_no_malloc.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Every driver path used after init with SGP41_NO_HEAP, failing
+  *                   on any call to malloc(), calloc() or realloc()
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sgp41.h"
+#include "sgp41_pool.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define NO_MALLOC_SENSORS								2
+#define NO_MALLOC_START_US							1000000
+
+/* Jitter scenario, held on its first wait so a second benchmark overlaps it */
+#define NO_MALLOC_JITTER_PERIOD_MS			10
+#define NO_MALLOC_JITTER_SAMPLES				20
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t bus;
+static sgp41_sim_device_t devs[NO_MALLOC_SENSORS];
+static sgp41_sim_port_t ports[NO_MALLOC_SENSORS];
+static sgp41_t sensors[NO_MALLOC_SENSORS];
+static sgp41_t *instances[NO_MALLOC_SENSORS];
+
+/* Allocations counted once armed, from any thread */
+static bool armed = false;
+static uint32_t allocations = 0;
+
+/* Probed by the bus load task, the host bus answers no probe */
+static uint8_t load_bus_storage;
+
+static uint32_t jitter_buffer[NO_MALLOC_JITTER_SAMPLES - 1];
+static sgp41_jitter_config_t jitter_config = {
+		.period_ms = NO_MALLOC_JITTER_PERIOD_MS,
+		.samples = NO_MALLOC_JITTER_SAMPLES,
+		.deadline_us = 1000,
+		.cpu_load = true,
+		.load_bus = (i2c_master_bus_handle_t)&load_bus_storage,
+		.load_addr = SGP41_I2C_ADDR,
+		.buffer = jitter_buffer
+};
+
+/* Driver clock forwarding to the simulated one, able to hold a wait */
+static sgp41_clock_t gate_clock;
+static bool gate_hold = false;
+static bool gate_held = false;
+
+static StaticTask_t jitter_task_buffer;
+static StackType_t jitter_task_stack[SGP41_BENCHMARK_LOAD_STACK_SIZE];
+static esp_err_t jitter_task_ret;
+static FILE *sink;
+
+/* Private function prototypes -----------------------------------------------*/
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Function that records an allocation made while armed
+ */
+static void no_malloc_count(void);
+
+/**
+ * @brief Function that returns the time of the simulated clock
+ *
+ * @param ctx : Unused
+ *
+ * @return Virtual time in us
+ */
+static int64_t no_malloc_now_us(void *ctx);
+
+/**
+ * @brief Function that advances the simulated clock, after waiting for the
+ * test to release the gate if it is held
+ *
+ * @param ctx       : Unused
+ * @param period_us : Time to advance
+ */
+static void no_malloc_wait_us(void *ctx, uint32_t period_us);
+
+/**
+ * @brief Function that runs the jitter benchmark in its own task, so another
+ * benchmark can be started while it runs
+ *
+ * @param arg : Unused
+ */
+static void no_malloc_jitter_task(void *arg);
+
+/**
+ * @brief Function that checks a result and prints it on failure
+ *
+ * @param what     : Name of the call
+ * @param ret      : Result of the call
+ * @param expected : Expected result
+ *
+ * @return 0 if the result is the expected one, 1 otherwise
+ */
+static int no_malloc_expect(const char *what, esp_err_t ret, esp_err_t expected);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, NO_MALLOC_START_US);
+	gate_clock = (sgp41_clock_t) {
+			.now_us = no_malloc_now_us,
+			.wait_us = no_malloc_wait_us
+	};
+	sgp41_set_clock(&gate_clock);
+	sgp41_sim_bus_init(&bus, &clock);
+
+	for (uint8_t i = 0; i < NO_MALLOC_SENSORS; i++) {
+		sgp41_sim_device_init(&devs[i], &clock, 0x2000u + i);
+		esp_err_t ret = sgp41_init_with_transport(&sensors[i],
+				sgp41_sim_attach(&ports[i], &bus, i, &devs[i]));
+
+		if (ret != ESP_OK) {
+			printf("FAIL: sensor %u init, %s\n", i, esp_err_to_name(ret));
+			return 1;
+		}
+
+		instances[i] = &sensors[i];
+	}
+
+	/* Streams allocate their buffers when opened, before the check starts */
+	sink = fopen("/dev/null", "w");
+	setvbuf(sink, NULL, _IONBF, 0);
+	__atomic_store_n(&armed, true, __ATOMIC_SEQ_CST);
+
+	sgp41_t *me = &sensors[0];
+	uint16_t sraw_voc, sraw_nox, test_result, serial_number[3];
+	const uint16_t tx[2] = {SGP41_DEFAULT_RH, SGP41_DEFAULT_T};
+	uint16_t rx[2];
+	sgp41_sample_t sample;
+	int failed = 0;
+
+	failed |= no_malloc_expect("sgp41_execute_conditioning",
+			sgp41_execute_conditioning(me, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+			&sraw_voc), ESP_OK);
+	failed |= no_malloc_expect("sgp41_measure_raw_signals",
+			sgp41_measure_raw_signals(me, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+			&sraw_voc, &sraw_nox), ESP_OK);
+	failed |= no_malloc_expect("sgp41_execute_self_test",
+			sgp41_execute_self_test(me, &test_result), ESP_OK);
+	failed |= no_malloc_expect("sgp41_get_serial_number",
+			sgp41_get_serial_number(me, serial_number), ESP_OK);
+	failed |= no_malloc_expect("sgp41_get_latest",
+			sgp41_get_latest(me, 0, SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sample),
+			ESP_OK);
+	failed |= no_malloc_expect("sgp41_request",
+			sgp41_request(me, SGP41_CMD_MEASURE, 1, tx, rx), ESP_OK);
+	failed |= no_malloc_expect("sgp41_request_measure",
+			sgp41_request_measure(me, 1, SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sample),
+			ESP_OK);
+
+	sgp41_sample_t *pooled = sgp41_sample_alloc();
+
+	if (pooled == NULL) {
+		printf("FAIL: sample pool empty\n");
+		failed = 1;
+	}
+
+	sgp41_sample_free(pooled);
+
+	failed |= no_malloc_expect("sgp41_benchmark_run",
+			sgp41_benchmark_run(me, 10, sink), ESP_OK);
+	failed |= no_malloc_expect("sgp41_benchmark_stress",
+			sgp41_benchmark_stress(instances, NO_MALLOC_SENSORS, 5, sink), ESP_OK);
+
+	/* Without a buffer the jitter benchmark has nothing to fill */
+	sgp41_jitter_config_t no_buffer = jitter_config;
+	no_buffer.buffer = NULL;
+	failed |= no_malloc_expect("sgp41_benchmark_jitter without buffer",
+			sgp41_benchmark_jitter(me, &no_buffer, sink), ESP_ERR_INVALID_ARG);
+
+	/* Jitter with both load tasks, overlapped by a second benchmark */
+	__atomic_store_n(&gate_hold, true, __ATOMIC_SEQ_CST);
+	TaskHandle_t task = xTaskCreateStatic(no_malloc_jitter_task, "jitter",
+			SGP41_BENCHMARK_LOAD_STACK_SIZE, NULL, uxTaskPriorityGet(NULL),
+			jitter_task_stack, &jitter_task_buffer);
+
+	while (!__atomic_load_n(&gate_held, __ATOMIC_SEQ_CST)) {
+		vTaskDelay(1);
+	}
+
+	failed |= no_malloc_expect("sgp41_benchmark_run during jitter",
+			sgp41_benchmark_run(NULL, 10, sink), ESP_ERR_INVALID_STATE);
+	__atomic_store_n(&gate_hold, false, __ATOMIC_SEQ_CST);
+
+	while (eTaskGetState(task) != eSuspended) {
+		vTaskDelay(1);
+	}
+
+	vTaskDelete(task);
+	failed |= no_malloc_expect("sgp41_benchmark_jitter", jitter_task_ret, ESP_OK);
+
+	/* The load tasks are gone, their storage can start them again */
+	failed |= no_malloc_expect("sgp41_benchmark_jitter again",
+			sgp41_benchmark_jitter(me, &jitter_config, sink), ESP_OK);
+
+	failed |= no_malloc_expect("sgp41_trace_dump", sgp41_trace_dump(sink),
+			ESP_OK);
+	failed |= no_malloc_expect("sgp41_trace_dump_json",
+			sgp41_trace_dump_json(sink), ESP_OK);
+	failed |= no_malloc_expect("sgp41_log_dump", sgp41_log_dump(sink), ESP_OK);
+
+	for (uint8_t i = 0; i < NO_MALLOC_SENSORS; i++) {
+		failed |= no_malloc_expect("sgp41_deinit", sgp41_deinit(&sensors[i]),
+				ESP_OK);
+	}
+
+	__atomic_store_n(&armed, false, __ATOMIC_SEQ_CST);
+	fclose(sink);
+	sgp41_set_clock(NULL);
+
+	if (allocations != 0) {
+		printf("FAIL: %u allocations after init\n", allocations);
+		failed = 1;
+	}
+
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function that replaces malloc() at link time
+ */
+void *__wrap_malloc(size_t size) {
+	no_malloc_count();
+
+	return __real_malloc(size);
+}
+
+/**
+ * @brief Function that replaces calloc() at link time
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+	no_malloc_count();
+
+	return __real_calloc(count, size);
+}
+
+/**
+ * @brief Function that replaces realloc() at link time
+ */
+void *__wrap_realloc(void *ptr, size_t size) {
+	no_malloc_count();
+
+	return __real_realloc(ptr, size);
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that records an allocation made while armed
+ */
+static void no_malloc_count(void) {
+	if (__atomic_load_n(&armed, __ATOMIC_SEQ_CST)) {
+		__atomic_fetch_add(&allocations, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+/**
+ * @brief Function that returns the time of the simulated clock
+ */
+static int64_t no_malloc_now_us(void *ctx) {
+	return clock.hook.now_us(clock.hook.ctx);
+}
+
+/**
+ * @brief Function that advances the simulated clock, once the gate is open
+ */
+static void no_malloc_wait_us(void *ctx, uint32_t period_us) {
+	if (__atomic_load_n(&gate_hold, __ATOMIC_SEQ_CST)) {
+		__atomic_store_n(&gate_held, true, __ATOMIC_SEQ_CST);
+
+		while (__atomic_load_n(&gate_hold, __ATOMIC_SEQ_CST)) {
+			vTaskDelay(1);
+		}
+	}
+
+	clock.hook.wait_us(clock.hook.ctx, period_us);
+}
+
+/**
+ * @brief Function that runs the jitter benchmark in its own task
+ */
+static void no_malloc_jitter_task(void *arg) {
+	jitter_task_ret = sgp41_benchmark_jitter(&sensors[0], &jitter_config, sink);
+
+	/* Parked until main() deletes the task */
+	vTaskSuspend(NULL);
+}
+
+/**
+ * @brief Function that checks a result and prints it on failure
+ */
+static int no_malloc_expect(const char *what, esp_err_t ret, esp_err_t expected) {
+	if (ret == expected) {
+		return 0;
+	}
+
+	printf("FAIL: %s returned %s, expected %s\n", what, esp_err_to_name(ret),
+			esp_err_to_name(expected));
+
+	return 1;
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,277 @@
+/**
+  ******************************************************************************
+  * @file           : test_phases.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Phase accounting of the driver on simulated sensors: a batch books
+  *                   its shared wait once, and failed phases are recorded with their error
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sgp41.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define PHASES_START_US									1000000
+#define PHASES_SENSORS									4
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t bus;
+static sgp41_sim_device_t devs[PHASES_SENSORS];
+static sgp41_sim_port_t ports[PHASES_SENSORS];
+static sgp41_t sensors[PHASES_SENSORS];
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that clears the statistics and the trace of every sensor
+ */
+static void phases_reset(void);
+
+/**
+ * @brief Function that checks the CPU time and the latency booked by a batch
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int phases_batch(void);
+
+/**
+ * @brief Function that checks the phases recorded for failed commands
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int phases_failed(void);
+
+/**
+ * @brief Function that returns the newest trace event
+ *
+ * @param event : Pointer where the event is stored
+ *
+ * @return true if there is one
+ */
+static bool phases_last_event(sgp41_trace_event_t *event);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, PHASES_START_US);
+	sgp41_set_clock(&clock.hook);
+	sgp41_sim_bus_init(&bus, &clock);
+
+	for (uint8_t i = 0; i < PHASES_SENSORS; i++) {
+		sgp41_sim_device_init(&devs[i], &clock, 0x4000u + i);
+
+		esp_err_t ret = sgp41_init_with_transport(&sensors[i],
+				sgp41_sim_attach(&ports[i], &bus, i, &devs[i]));
+
+		if (ret != ESP_OK) {
+			printf("FAIL: init %u, %s\n", i, esp_err_to_name(ret));
+			return 1;
+		}
+	}
+
+	int failed = phases_batch();
+	failed |= phases_failed();
+
+	for (uint8_t i = 0; i < PHASES_SENSORS; i++) {
+		sgp41_deinit(&sensors[i]);
+	}
+
+	sgp41_set_clock(NULL);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that clears the statistics and the trace of every sensor
+ */
+static void phases_reset(void) {
+	for (uint8_t i = 0; i < PHASES_SENSORS; i++) {
+		sgp41_reset_cpu_stats(&sensors[i]);
+		sgp41_reset_latency_stats(&sensors[i]);
+	}
+
+	sgp41_trace_clear();
+}
+
+/**
+ * @brief Function that checks the CPU time and the latency booked by a batch
+ */
+static int phases_batch(void) {
+	sgp41_t *instances[PHASES_SENSORS];
+	sgp41_sample_t samples[PHASES_SENSORS];
+
+	for (uint8_t i = 0; i < PHASES_SENSORS; i++) {
+		instances[i] = &sensors[i];
+	}
+
+	phases_reset();
+
+	esp_err_t ret = sgp41_measure_batch(instances, PHASES_SENSORS,
+			SGP41_DEFAULT_RH, SGP41_DEFAULT_T, samples);
+
+	if (ret != ESP_OK) {
+		printf("FAIL: batch, %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	/* The busy wait spun once for the whole batch */
+	uint64_t spin_us = 0, wait_sum_us = 0;
+	uint32_t commands = 0, waits = 0;
+
+	for (uint8_t i = 0; i < PHASES_SENSORS; i++) {
+		sgp41_cpu_stats_t cpu;
+		sgp41_latency_stats_t latency;
+		sgp41_get_cpu_stats(&sensors[i], &cpu);
+		sgp41_get_latency_stats(&sensors[i], &latency);
+
+		const sgp41_latency_hist_t *wait =
+				&latency.hist[SGP41_CMD_MEASURE][SGP41_PHASE_WAIT];
+		spin_us += cpu.spin_us[SGP41_CMD_MEASURE];
+		commands += cpu.commands[SGP41_CMD_MEASURE];
+		waits += wait->count;
+		wait_sum_us += wait->sum_us;
+	}
+
+	uint32_t wait_us = sgp41_codec_descs[SGP41_CMD_MEASURE].wait_us;
+	int failed = 0;
+
+	if (spin_us != wait_us || waits != 1 || wait_sum_us != wait_us ||
+			commands != PHASES_SENSORS) {
+		printf("FAIL: batch booked %" PRIu64 " us spinning and %" PRIu32 " waits "
+				"of %" PRIu64 " us for %" PRIu32 " commands, expected one wait of %"
+				PRIu32 " us\n", spin_us, waits, wait_sum_us, commands, wait_us);
+		failed = 1;
+	}
+
+	return failed;
+}
+
+/**
+ * @brief Function that checks the phases recorded for failed commands
+ */
+static int phases_failed(void) {
+	sgp41_t *const me = &sensors[0];
+	sgp41_sim_device_t *dev = &devs[0];
+	uint16_t sraw_voc, sraw_nox;
+	sgp41_latency_stats_t latency;
+	sgp41_cpu_stats_t cpu;
+	sgp41_trace_event_t event;
+	int failed = 0;
+
+	/* A refused write is timed and counted as a command */
+	phases_reset();
+	dev->nack_fault_period = 1;
+	esp_err_t ret = sgp41_measure_raw_signals(me, SGP41_DEFAULT_RH,
+			SGP41_DEFAULT_T, &sraw_voc, &sraw_nox);
+	dev->nack_fault_period = 0;
+
+	sgp41_get_latency_stats(me, &latency);
+	sgp41_get_cpu_stats(me, &cpu);
+	const sgp41_latency_hist_t *write =
+			&latency.hist[SGP41_CMD_MEASURE][SGP41_PHASE_WRITE];
+
+	if (ret != SGP41_ERR_WRITE_NACK || write->count != 1 ||
+			write->failures != 1 || cpu.commands[SGP41_CMD_MEASURE] != 1 ||
+			!phases_last_event(&event) || event.phase != SGP41_PHASE_WRITE ||
+			event.status != SGP41_ERR_WRITE_NACK) {
+		printf("FAIL: refused write not recorded\n");
+		failed = 1;
+	}
+
+	/* A corrupted response is timed up to the check that failed */
+	phases_reset();
+	dev->crc_fault_period = 1;
+	ret = sgp41_measure_raw_signals(me, SGP41_DEFAULT_RH, SGP41_DEFAULT_T,
+			&sraw_voc, &sraw_nox);
+	dev->crc_fault_period = 0;
+
+	sgp41_get_latency_stats(me, &latency);
+	const sgp41_latency_hist_t *read =
+			&latency.hist[SGP41_CMD_MEASURE][SGP41_PHASE_READ];
+	const sgp41_latency_hist_t *crc =
+			&latency.hist[SGP41_CMD_MEASURE][SGP41_PHASE_CRC];
+
+	if (ret != ESP_ERR_INVALID_CRC || read->count != 1 || read->failures != 0 ||
+			crc->count != 1 || crc->failures != 1 || !phases_last_event(&event) ||
+			event.phase != SGP41_PHASE_CRC || event.status != ESP_ERR_INVALID_CRC) {
+		printf("FAIL: corrupted response not recorded\n");
+		failed = 1;
+	}
+
+	/* Both dumps carry the error of the failed phase, and only of that one */
+	char *json, *raw;
+	size_t json_len, raw_len;
+	FILE *stream = open_memstream(&json, &json_len);
+	sgp41_trace_dump_json(stream);
+	fclose(stream);
+	stream = open_memstream(&raw, &raw_len);
+	sgp41_trace_dump(stream);
+	fclose(stream);
+
+	const char *args = strstr(json, "\"args\":{\"status\":\"ESP_ERR_INVALID_CRC\"}");
+	char line[64];
+	snprintf(line, sizeof(line), " %u %u %d\n", SGP41_CMD_MEASURE,
+			SGP41_PHASE_CRC, ESP_ERR_INVALID_CRC);
+
+	if (args == NULL || strstr(args + 1, "\"args\"") != NULL ||
+			strstr(json, "crc\"") == NULL || strstr(raw, line) == NULL) {
+		printf("FAIL: trace dumps without the status\n%s%s", json, raw);
+		failed = 1;
+	}
+
+	free(json);
+	free(raw);
+
+	return failed;
+}
+
+/**
+ * @brief Function that returns the newest trace event
+ */
+static bool phases_last_event(sgp41_trace_event_t *event) {
+	sgp41_trace_event_t events[CONFIG_SGP41_TRACE_RING_SIZE];
+	size_t count = sgp41_trace_snapshot(events, CONFIG_SGP41_TRACE_RING_SIZE);
+
+	if (count == 0) {
+		return false;
+	}
+
+	*event = events[count - 1];
+
+	return true;
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,564 @@
+/**
+  ******************************************************************************
+  * @file           : test_prometheus.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : Prometheus exposition of simulated sensors: the exact text, the same
+  *                   text through any buffer size and scraped over the loopback endpoint
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "sgp41.h"
+#include "sgp41_prometheus.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define PROM_START_US										1000000
+#define PROM_SENSORS										2
+#define PROM_MEASUREMENTS								3
+#define PROM_TEXT_LEN_MAX								(256 * 1024)
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t bus;
+static sgp41_sim_device_t devs[PROM_SENSORS];
+static sgp41_sim_port_t ports[PROM_SENSORS];
+static sgp41_t sensors[PROM_SENSORS];
+
+/* Upper bounds of the latency buckets but the last one, written out */
+static const uint32_t bucket_bounds[SGP41_LATENCY_BUCKETS - 1] = {
+		1, 3, 7, 15, 31, 63, 127, 255, 511, 1023, 2047, 4095, 8191, 16383, 32767,
+		65535, 131071, 262143, 524287
+};
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that renders the whole exposition through a buffer
+ *
+ * @param len    : Size of the buffer
+ * @param chunks : Pointer where the number of chunks is stored
+ *
+ * @return Text to be freed, NULL if a chunk was not made of whole lines
+ */
+static char *prom_render(size_t len, uint32_t *chunks);
+
+/**
+ * @brief Function that checks the exposition against the text it must be
+ *
+ * @param text : Pointer to the exposition
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int prom_exact(const char *text);
+
+/**
+ * @brief Function that checks that every buffer size gives the same text
+ *
+ * @param text : Pointer to the exposition rendered at once
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int prom_split(const char *text);
+
+/**
+ * @brief Function that scrapes the exposition from the HTTP endpoint
+ *
+ * @param text : Pointer to the exposition rendered at once
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int prom_scrape(const char *text);
+
+/**
+ * @brief Function that checks that the cursor moves on past an instance
+ * released while rendering
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int prom_release(void);
+
+/**
+ * @brief Function that sends a GET request to a local port
+ *
+ * @param port     : Port of the server
+ * @param uri      : URI requested
+ * @param response : Pointer where the response is stored, to be freed
+ *
+ * @return true if the whole response was read
+ */
+static bool prom_get(uint16_t port, const char *uri, char **response);
+
+/**
+ * @brief Function that joins the chunks of a chunked HTTP body
+ *
+ * @param body : Pointer to the body, decoded in place
+ *
+ * @return true if the body was well formed
+ */
+static bool prom_dechunk(char *body);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, PROM_START_US);
+	sgp41_set_clock(&clock.hook);
+	sgp41_sim_bus_init(&bus, &clock);
+
+	for (uint8_t i = 0; i < PROM_SENSORS; i++) {
+		sgp41_sim_device_init(&devs[i], &clock, 0x9000u + i);
+
+		esp_err_t ret = sgp41_init_with_transport(&sensors[i],
+				sgp41_sim_attach(&ports[i], &bus, i, &devs[i]));
+
+		if (ret != ESP_OK) {
+			printf("FAIL: init %u, %s\n", i, esp_err_to_name(ret));
+			return 1;
+		}
+
+		for (uint8_t j = 0; j < PROM_MEASUREMENTS; j++) {
+			sgp41_sample_t sample;
+			sgp41_measure(&sensors[i], SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sample);
+		}
+	}
+
+	uint32_t chunks;
+	char *text = prom_render(PROM_TEXT_LEN_MAX, &chunks);
+
+	if (text == NULL || chunks != 1) {
+		printf("FAIL: exposition not rendered at once\n");
+		return 1;
+	}
+
+	int failed = prom_exact(text);
+	failed |= prom_split(text);
+	failed |= prom_scrape(text);
+	failed |= prom_release();
+
+	free(text);
+
+	for (uint8_t i = 0; i < PROM_SENSORS; i++) {
+		sgp41_deinit(&sensors[i]);
+	}
+
+	sgp41_set_clock(NULL);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that renders the whole exposition through a buffer
+ */
+static char *prom_render(size_t len, uint32_t *chunks) {
+	char *buf = malloc(len), *text;
+	size_t text_len, written;
+	FILE *stream = open_memstream(&text, &text_len);
+	sgp41_prometheus_cursor_t cursor;
+	bool whole = true;
+
+	sgp41_prometheus_begin(&cursor);
+	*chunks = 0;
+
+	for (;;) {
+		esp_err_t ret = sgp41_prometheus_render(&cursor, buf, len, &written);
+
+		if (ret != ESP_OK || written == 0) {
+			whole = ret == ESP_OK;
+			break;
+		}
+
+		/* Whole lines only, with room left for snprintf() to terminate them */
+		if (written >= len || buf[written - 1] != '\n') {
+			whole = false;
+		}
+
+		fwrite(buf, 1, written, stream);
+		(*chunks)++;
+	}
+
+	fclose(stream);
+	free(buf);
+
+	if (!whole) {
+		free(text);
+		return NULL;
+	}
+
+	return text;
+}
+
+/**
+ * @brief Function that checks the exposition against the text it must be
+ */
+static int prom_exact(const char *text) {
+	char *expected;
+	size_t expected_len;
+	FILE *stream = open_memstream(&expected, &expected_len);
+
+	/* The families of the latest sample and self test, newest instance first */
+	fprintf(stream, "# HELP sgp41_sraw_voc Latest VOC raw signal in ticks\n"
+			"# TYPE sgp41_sraw_voc gauge\n");
+
+	for (int i = PROM_SENSORS - 1; i >= 0; i--) {
+		fprintf(stream, "sgp41_sraw_voc{instance=\"%u\"} %u\n", sensors[i].id,
+				sensors[i].sraw_voc);
+	}
+
+	fprintf(stream, "# HELP sgp41_sraw_nox Latest NOx raw signal in ticks\n"
+			"# TYPE sgp41_sraw_nox gauge\n");
+
+	for (int i = PROM_SENSORS - 1; i >= 0; i--) {
+		fprintf(stream, "sgp41_sraw_nox{instance=\"%u\"} %u\n", sensors[i].id,
+				sensors[i].sraw_nox);
+	}
+
+	fprintf(stream, "# HELP sgp41_sample_timestamp_us Monotonic time of the "
+			"latest sample\n# TYPE sgp41_sample_timestamp_us gauge\n");
+
+	for (int i = PROM_SENSORS - 1; i >= 0; i--) {
+		fprintf(stream, "sgp41_sample_timestamp_us{instance=\"%u\"} %" PRId64 "\n",
+				sensors[i].id, sensors[i].sample_us);
+	}
+
+	fprintf(stream, "# HELP sgp41_self_test_pixel_ok 1 if the pixel passed the "
+			"latest self test\n# TYPE sgp41_self_test_pixel_ok gauge\n");
+
+	for (int i = PROM_SENSORS - 1; i >= 0; i--) {
+		fprintf(stream, "sgp41_self_test_pixel_ok{instance=\"%u\",pixel=\"voc\"} 1\n"
+				"sgp41_self_test_pixel_ok{instance=\"%u\",pixel=\"nox\"} 1\n",
+				sensors[i].id, sensors[i].id);
+	}
+
+	fprintf(stream, "# HELP sgp41_phase_duration_us Duration of each command "
+			"phase\n# TYPE sgp41_phase_duration_us histogram\n");
+	fclose(stream);
+
+	int failed = 0;
+
+	if (strncmp(text, expected, expected_len) != 0) {
+		printf("FAIL: exposition starts with\n%.*s\nexpected\n%s", (int)expected_len,
+				text, expected);
+		failed = 1;
+	}
+
+	free(expected);
+
+	/* Every measurement waited 50 ms exactly, in the bucket below 65536 us */
+	stream = open_memstream(&expected, &expected_len);
+	uint16_t id = sensors[0].id;
+	const char *labels = "cmd=\"measure\",phase=\"wait\"";
+
+	for (uint8_t i = 0; i < SGP41_LATENCY_BUCKETS - 1; i++) {
+		fprintf(stream, "sgp41_phase_duration_us_bucket{instance=\"%u\",%s,le=\"%"
+				PRIu32 "\"} %u\n", id, labels, bucket_bounds[i],
+				bucket_bounds[i] >= 50000 ? PROM_MEASUREMENTS : 0);
+	}
+
+	fprintf(stream, "sgp41_phase_duration_us_bucket{instance=\"%u\",%s,"
+			"le=\"+Inf\"} %u\n", id, labels, PROM_MEASUREMENTS);
+	fprintf(stream, "sgp41_phase_duration_us_sum{instance=\"%u\",%s} %u\n", id,
+			labels, PROM_MEASUREMENTS * 50000);
+	fprintf(stream, "sgp41_phase_duration_us_count{instance=\"%u\",%s} %u\n", id,
+			labels, PROM_MEASUREMENTS);
+	fclose(stream);
+
+	/* The block follows the one of the write phase */
+	const char *block = strstr(text, expected);
+
+	if (block == NULL || block[-1] != '\n' ||
+			strncmp(block + expected_len, "sgp41_phase_duration_us_bucket{instance=",
+					40) != 0) {
+		printf("FAIL: no histogram block\n%s", expected);
+		failed = 1;
+	}
+
+	free(expected);
+
+	/* The counter families close the exposition, one per descriptor */
+	size_t descs_len;
+	const sgp41_metric_desc_t *descs = sgp41_metrics_get_descs(&descs_len);
+	stream = open_memstream(&expected, &expected_len);
+
+	for (size_t i = 0; i < descs_len; i++) {
+		fprintf(stream, "# HELP sgp41_%s_total %s\n# TYPE sgp41_%s_total counter\n",
+				descs[i].name, descs[i].help, descs[i].name);
+
+		for (int j = PROM_SENSORS - 1; j >= 0; j--) {
+			fprintf(stream, "sgp41_%s_total{instance=\"%u\"} %" PRIu32 "\n",
+					descs[i].name, sensors[j].id, sgp41_metrics_read(&sensors[j], i));
+		}
+	}
+
+	fclose(stream);
+
+	size_t text_len = strlen(text);
+
+	if (text_len < expected_len ||
+			strcmp(text + text_len - expected_len, expected) != 0) {
+		printf("FAIL: exposition does not end with the counters\n%s", expected);
+		failed = 1;
+	}
+
+	free(expected);
+
+	/* Nothing else: the headers and the lines of every family */
+	uint32_t lines = 0;
+
+	for (const char *c = text; *c != '\0'; c++) {
+		lines += *c == '\n';
+	}
+
+	uint32_t expected_lines = (5 + descs_len) * 2 + PROM_SENSORS * (3 + 2 +
+			SGP41_CMD_MAX * SGP41_PHASE_MAX * (SGP41_LATENCY_BUCKETS + 2) + descs_len);
+
+	if (lines != expected_lines) {
+		printf("FAIL: %" PRIu32 " lines, expected %" PRIu32 "\n", lines,
+				expected_lines);
+		failed = 1;
+	}
+
+	return failed;
+}
+
+/**
+ * @brief Function that checks that every buffer size gives the same text
+ */
+static int prom_split(const char *text) {
+	static const size_t lens[] = {
+			SGP41_PROMETHEUS_LINE_LEN_MAX, SGP41_PROMETHEUS_LINE_LEN_MAX + 1, 257,
+			CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE, 4093
+	};
+	int failed = 0;
+
+	for (uint8_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+		uint32_t chunks;
+		char *split = prom_render(lens[i], &chunks);
+
+		if (split == NULL || strcmp(split, text) != 0 ||
+				chunks < strlen(text) / lens[i]) {
+			printf("FAIL: %zu byte buffer gives another exposition\n", lens[i]);
+			failed = 1;
+		}
+
+		free(split);
+	}
+
+	/* A buffer too small for a line is reported, not spun on */
+	char small[16];
+	size_t written;
+	sgp41_prometheus_cursor_t cursor;
+	sgp41_prometheus_begin(&cursor);
+
+	if (sgp41_prometheus_render(&cursor, small, sizeof(small), &written) !=
+			ESP_ERR_INVALID_SIZE) {
+		printf("FAIL: line longer than the buffer not reported\n");
+		failed = 1;
+	}
+
+	return failed;
+}
+
+/**
+ * @brief Function that scrapes the exposition from the HTTP endpoint
+ */
+static int prom_scrape(const char *text) {
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	httpd_handle_t server;
+	config.server_port = 0;
+
+	if (httpd_start(&server, &config) != ESP_OK ||
+			sgp41_prometheus_register(server, "/metrics") != ESP_OK) {
+		printf("FAIL: endpoint not started\n");
+		return 1;
+	}
+
+	int failed = 0;
+	char *response, *missing;
+
+	if (!prom_get(httpd_host_port(server), "/metrics", &response) ||
+			!prom_get(httpd_host_port(server), "/other", &missing)) {
+		printf("FAIL: endpoint not reached\n");
+		httpd_stop(server);
+		return 1;
+	}
+
+	char *body = strstr(response, "\r\n\r\n");
+
+	if (strncmp(response, "HTTP/1.1 200 OK\r\n", 17) != 0 ||
+			strstr(response, "Content-Type: text/plain; version=0.0.4\r\n") == NULL ||
+			body == NULL || !prom_dechunk(body + 4) || strcmp(body + 4, text) != 0) {
+		printf("FAIL: scraped exposition differs\n");
+		failed = 1;
+	}
+
+	if (strncmp(missing, "HTTP/1.1 404", 12) != 0) {
+		printf("FAIL: unknown URI answered\n");
+		failed = 1;
+	}
+
+	free(response);
+	free(missing);
+	httpd_stop(server);
+
+	return failed;
+}
+
+/**
+ * @brief Function that checks that the cursor moves on past an instance
+ * released while rendering
+ */
+static int prom_release(void) {
+	char buf[CONFIG_SGP41_PROMETHEUS_CHUNK_SIZE], label[32];
+	size_t written;
+	sgp41_prometheus_cursor_t cursor;
+	int failed = 0;
+
+	snprintf(label, sizeof(label), "instance=\"%u\"", sensors[1].id);
+	sgp41_prometheus_begin(&cursor);
+
+	/* The first chunk holds lines of both instances */
+	if (sgp41_prometheus_render(&cursor, buf, sizeof(buf), &written) != ESP_OK ||
+			written == 0) {
+		printf("FAIL: first chunk\n");
+		return 1;
+	}
+
+	sgp41_deinit(&sensors[1]);
+
+	for (;;) {
+		if (sgp41_prometheus_render(&cursor, buf, sizeof(buf), &written) !=
+				ESP_OK) {
+			printf("FAIL: rendering after a release\n");
+			failed = 1;
+			break;
+		}
+
+		if (written == 0) {
+			break;
+		}
+
+		buf[written] = '\0';
+
+		if (strstr(buf, label) != NULL) {
+			printf("FAIL: released instance still rendered\n");
+			failed = 1;
+			break;
+		}
+	}
+
+	return failed;
+}
+
+/**
+ * @brief Function that sends a GET request to a local port
+ */
+static bool prom_get(uint16_t port, const char *uri, char **response) {
+	struct sockaddr_in addr = {
+			.sin_family = AF_INET,
+			.sin_port = htons(port),
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+	};
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		return false;
+	}
+
+	char request[128];
+	int request_len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\n"
+			"Host: localhost\r\n\r\n", uri);
+	size_t response_len;
+	FILE *stream = open_memstream(response, &response_len);
+	bool ok = send(fd, request, request_len, 0) == request_len;
+
+	/* The server closes the connection after the response */
+	while (ok) {
+		char buf[4096];
+		ssize_t n = recv(fd, buf, sizeof(buf), 0);
+
+		if (n <= 0) {
+			ok = n == 0;
+			break;
+		}
+
+		fwrite(buf, 1, n, stream);
+	}
+
+	fclose(stream);
+	close(fd);
+
+	return ok;
+}
+
+/**
+ * @brief Function that joins the chunks of a chunked HTTP body
+ */
+static bool prom_dechunk(char *body) {
+	const char *in = body;
+	char *out = body;
+
+	for (;;) {
+		char *end;
+		unsigned long len = strtoul(in, &end, 16);
+
+		if (end == in || strncmp(end, "\r\n", 2) != 0) {
+			return false;
+		}
+
+		in = end + 2;
+
+		if (len == 0) {
+			*out = '\0';
+			return strcmp(in, "\r\n") == 0;
+		}
+
+		if (strlen(in) < len + 2 || strncmp(in + len, "\r\n", 2) != 0) {
+			return false;
+		}
+
+		memmove(out, in, len);
+		out += len;
+		in += len + 2;
+	}
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,210 @@
+/**
+  ******************************************************************************
+  * @file           : test_retry.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : CRC retries on a simulated sensor: responses the sensor keeps are read
+  *                   again, measurements are executed again, within the budget of the retries
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sgp41.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define RETRY_START_US									1000000
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	uint32_t writes;													/* Commands written */
+	uint32_t reads;														/* Responses read */
+	uint32_t retries;													/* Retries counted by the driver */
+	uint32_t recoveries;											/* Commands recovered by a retry */
+} retry_counts_t;
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t bus;
+static sgp41_sim_device_t dev;
+static sgp41_sim_port_t port;
+static sgp41_t sensor;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that takes the counts a command is checked against
+ *
+ * @return Current counts
+ */
+static retry_counts_t retry_counts(void);
+
+/**
+ * @brief Function that checks the counts a command added
+ *
+ * @param name       : Name of the case, printed on failure
+ * @param before     : Counts before the command
+ * @param writes     : Commands written by it
+ * @param reads      : Responses read by it
+ * @param recoveries : Commands it recovered
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int retry_check(const char *name, retry_counts_t before, uint32_t writes,
+		                   uint32_t reads, uint32_t recoveries);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, RETRY_START_US);
+	sgp41_set_clock(&clock.hook);
+	sgp41_sim_bus_init(&bus, &clock);
+	sgp41_sim_device_init(&dev, &clock, 0x7000u);
+
+	esp_err_t ret = sgp41_init_with_transport(&sensor,
+			sgp41_sim_attach(&port, &bus, 0, &dev));
+
+	if (ret != ESP_OK) {
+		printf("FAIL: init, %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	int failed = 0;
+	uint16_t test_result, serial[3];
+	sgp41_sample_t sample;
+
+	/* The self test takes longer than the budget, its response is read again */
+	retry_counts_t before = retry_counts();
+	dev.crc_fault_period = dev.reads + 1;
+	ret = sgp41_execute_self_test(&sensor, &test_result);
+
+	if (ret != ESP_OK || test_result != dev.test_result) {
+		printf("FAIL: self test not recovered, %s\n", esp_err_to_name(ret));
+		failed = 1;
+	}
+
+	failed |= retry_check("self test", before, 1, 2, 1);
+
+	before = retry_counts();
+	dev.crc_fault_period = dev.reads + 1;
+	ret = sgp41_get_serial_number(&sensor, serial);
+
+	if (ret != ESP_OK || serial[0] != dev.serial[0] ||
+			serial[2] != dev.serial[2]) {
+		printf("FAIL: serial number not recovered, %s\n", esp_err_to_name(ret));
+		failed = 1;
+	}
+
+	failed |= retry_check("serial number", before, 1, 2, 1);
+
+	/* A measurement is executed again for a new sample */
+	before = retry_counts();
+	dev.crc_fault_period = dev.reads + 1;
+	ret = sgp41_measure(&sensor, SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sample);
+
+	if (ret != ESP_OK || !(sample.flags & SGP41_SAMPLE_RECOVERED)) {
+		printf("FAIL: measurement not recovered, %s\n", esp_err_to_name(ret));
+		failed = 1;
+	}
+
+	failed |= retry_check("measurement", before, 2, 2, 1);
+
+	/* A sensor that keeps failing uses every retry, the default budget fits
+	 * them all for a measurement too */
+	dev.crc_fault_period = 1;
+	before = retry_counts();
+	ret = sgp41_execute_self_test(&sensor, &test_result);
+	failed |= retry_check("failing self test", before, 1,
+			1 + CONFIG_SGP41_CRC_RETRY_MAX, 0);
+
+	before = retry_counts();
+	int64_t start_us = clock.now_us;
+	ret = sgp41_measure(&sensor, SGP41_DEFAULT_RH, SGP41_DEFAULT_T, &sample);
+	int64_t elapsed_us = clock.now_us - start_us;
+	int64_t wait_us = sgp41_codec_descs[SGP41_CMD_MEASURE].wait_us;
+	failed |= retry_check("failing measurement", before,
+			1 + CONFIG_SGP41_CRC_RETRY_MAX, 1 + CONFIG_SGP41_CRC_RETRY_MAX, 0);
+
+	if (ret != ESP_ERR_INVALID_CRC || elapsed_us > wait_us +
+			CONFIG_SGP41_CRC_RETRY_BUDGET_MS * 1000LL) {
+		printf("FAIL: failing measurement took %" PRId64 " us, %s\n", elapsed_us,
+				esp_err_to_name(ret));
+		failed = 1;
+	}
+
+	dev.crc_fault_period = 0;
+
+	if (dev.bad_frames != 0 || dev.early_reads != 0) {
+		printf("FAIL: %" PRIu32 " bad frames and %" PRIu32 " early reads\n",
+				dev.bad_frames, dev.early_reads);
+		failed = 1;
+	}
+
+	sgp41_deinit(&sensor);
+	sgp41_set_clock(NULL);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that takes the counts a command is checked against
+ */
+static retry_counts_t retry_counts(void) {
+	return (retry_counts_t) {
+			.writes = dev.writes,
+			.reads = dev.reads,
+			.retries = sensor.counters.crc_retries,
+			.recoveries = sensor.counters.crc_recoveries
+	};
+}
+
+/**
+ * @brief Function that checks the counts a command added
+ */
+static int retry_check(const char *name, retry_counts_t before, uint32_t writes,
+		                   uint32_t reads, uint32_t recoveries) {
+	retry_counts_t after = retry_counts();
+
+	if (after.writes - before.writes != writes ||
+			after.reads - before.reads != reads ||
+			after.retries - before.retries != reads - 1 ||
+			after.recoveries - before.recoveries != recoveries) {
+		printf("FAIL: %s took %" PRIu32 " writes, %" PRIu32 " reads, %" PRIu32
+				" retries and %" PRIu32 " recoveries\n", name,
+				after.writes - before.writes, after.reads - before.reads,
+				after.retries - before.retries, after.recoveries - before.recoveries);
+		return 1;
+	}
+
+	return 0;
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,220 @@
+/**
+  ******************************************************************************
+  * @file           : test_soak.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : 24 hours of 1 Hz sampling on a virtual clock, run twice
+  *                   and compared through a digest of every sample
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sgp41.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define SOAK_SAMPLES										(24 * 3600)
+#define SOAK_PERIOD_US									1000000
+#define SOAK_START_US										1000000
+#define SOAK_SEED												0x5EED5EED
+
+/* Prime periods, so the faults drift over the commands of the day */
+#define SOAK_CRC_FAULT_PERIOD						10007
+#define SOAK_NACK_FAULT_PERIOD					50021
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	uint64_t digest;													/* Digest of samples and counters */
+	uint32_t samples;													/* Successful measurements */
+	uint32_t failures;												/* Failed measurements */
+	uint32_t bad_frames;											/* Frames the sensor refused */
+	uint32_t early_reads;											/* Reads before the response was ready */
+	int64_t elapsed_us;												/* Virtual time of the run */
+} soak_result_t;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that runs one day of sampling against a fresh simulated
+ * sensor
+ *
+ * @param result : Pointer where the result of the run is stored
+ *
+ * @return ESP_OK on success, the error of the driver setup otherwise
+ */
+static esp_err_t soak_run(soak_result_t *result);
+
+/**
+ * @brief Function that adds a sample to a digest, field by field so padding
+ * is left out
+ *
+ * @param digest : Digest so far
+ * @param sample : Pointer to the sample
+ *
+ * @return Updated digest
+ */
+static uint64_t soak_digest_sample(uint64_t digest,
+		                               const sgp41_sample_t *sample);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	soak_result_t runs[2];
+
+	for (uint8_t i = 0; i < 2; i++) {
+		esp_err_t ret = soak_run(&runs[i]);
+
+		if (ret != ESP_OK) {
+			printf("run %u: setup failed, %s\n", i, esp_err_to_name(ret));
+			return 1;
+		}
+
+		printf("run %u: digest %016" PRIx64 ", samples %" PRIu32 ", failures %"
+				PRIu32 ", virtual time %" PRId64 " s\n", i, runs[i].digest,
+				runs[i].samples, runs[i].failures, runs[i].elapsed_us / 1000000);
+	}
+
+	if (runs[0].digest != runs[1].digest) {
+		printf("FAIL: the runs differ\n");
+		return 1;
+	}
+
+	/* Every slot is sampled, the injected faults are the only failures */
+	if (runs[0].samples + runs[0].failures != SOAK_SAMPLES ||
+			runs[0].samples < SOAK_SAMPLES - SOAK_SAMPLES / 1000) {
+		printf("FAIL: %" PRIu32 " samples of %u\n", runs[0].samples, SOAK_SAMPLES);
+		return 1;
+	}
+
+	if (runs[0].bad_frames != 0 || runs[0].early_reads != 0) {
+		printf("FAIL: %" PRIu32 " frames refused, %" PRIu32 " reads too early\n",
+				runs[0].bad_frames, runs[0].early_reads);
+		return 1;
+	}
+
+	printf("PASS\n");
+
+	return 0;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that runs one day of sampling against a fresh simulated
+ * sensor
+ */
+static esp_err_t soak_run(soak_result_t *result) {
+	static sgp41_sim_clock_t clock;
+	static sgp41_sim_bus_t bus;
+	static sgp41_sim_device_t dev;
+	static sgp41_sim_port_t port;
+	static sgp41_t sensor;
+
+	sgp41_sim_clock_init(&clock, SOAK_START_US);
+	sgp41_sim_bus_init(&bus, &clock);
+	sgp41_sim_device_init(&dev, &clock, SOAK_SEED);
+	dev.crc_fault_period = SOAK_CRC_FAULT_PERIOD;
+	dev.nack_fault_period = SOAK_NACK_FAULT_PERIOD;
+
+	/* The clock is set before any instance exists, see sgp41_set_clock() */
+	esp_err_t ret = sgp41_set_clock(&clock.hook);
+
+	if (ret == ESP_OK) {
+		ret = sgp41_init_with_transport(&sensor,
+				sgp41_sim_attach(&port, &bus, 0, &dev));
+	}
+
+	if (ret != ESP_OK) {
+		sgp41_set_clock(NULL);
+		return ret;
+	}
+
+	*result = (soak_result_t) {.digest = SGP41_SIM_DIGEST_INIT};
+
+	for (uint32_t i = 0; i < SOAK_SAMPLES; i++) {
+		sgp41_sim_clock_advance_to(&clock,
+				SOAK_START_US + (int64_t)(i + 1) * SOAK_PERIOD_US);
+
+		/* Humidity and temperature cycle through the day */
+		uint16_t rh = (uint16_t)(0x6000 + (i % 7200) * 4);
+		uint16_t t = (uint16_t)(0x5800 + (i % 3600) * 2);
+		sgp41_sample_t sample;
+
+		ret = sgp41_measure(&sensor, rh, t, &sample);
+		result->digest = sgp41_sim_digest(result->digest, &ret, sizeof(ret));
+		result->digest = soak_digest_sample(result->digest, &sample);
+
+		if (ret == ESP_OK) {
+			result->samples++;
+		}
+		else {
+			result->failures++;
+		}
+	}
+
+#ifdef CONFIG_SGP41_METRICS
+	size_t descs_len;
+	sgp41_metrics_get_descs(&descs_len);
+
+	for (size_t i = 0; i < descs_len; i++) {
+		uint32_t value = sgp41_metrics_read(&sensor, i);
+		result->digest = sgp41_sim_digest(result->digest, &value, sizeof(value));
+	}
+#endif
+
+	result->bad_frames = dev.bad_frames;
+	result->early_reads = dev.early_reads;
+	result->elapsed_us = clock.now_us - SOAK_START_US;
+
+	sgp41_deinit(&sensor);
+	sgp41_set_clock(NULL);
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that adds a sample to a digest, field by field
+ */
+static uint64_t soak_digest_sample(uint64_t digest,
+		                               const sgp41_sample_t *sample) {
+	digest = sgp41_sim_digest(digest, &sample->timestamp_us,
+			sizeof(sample->timestamp_us));
+	digest = sgp41_sim_digest(digest, &sample->seq, sizeof(sample->seq));
+	digest = sgp41_sim_digest(digest, &sample->status, sizeof(sample->status));
+	digest = sgp41_sim_digest(digest, &sample->sraw_voc, sizeof(sample->sraw_voc));
+	digest = sgp41_sim_digest(digest, &sample->sraw_nox, sizeof(sample->sraw_nox));
+	digest = sgp41_sim_digest(digest, &sample->relative_humidity,
+			sizeof(sample->relative_humidity));
+	digest = sgp41_sim_digest(digest, &sample->temperature,
+			sizeof(sample->temperature));
+
+	return sgp41_sim_digest(digest, &sample->flags, sizeof(sample->flags));
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,238 @@
+/**
+  ******************************************************************************
+  * @file           : test_stress.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 17, 2026
+  * @brief          : 64 simulated sensors across simulated buses and mux
+  *                   channels, measured for an hour of virtual time by
+  *                   sgp41_benchmark_stress()
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sgp41.h"
+#include "sgp41_sim.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define STRESS_BUSES										8
+#define STRESS_SENSORS									(STRESS_BUSES * SGP41_SIM_MUX_CHANNELS)
+#define STRESS_START_US									1000000
+#define STRESS_DURATION_US							(3600LL * 1000000)
+
+/* A round measures every sensor once, 50 ms each plus the transfers */
+#define STRESS_ROUNDS										(uint32_t)(STRESS_DURATION_US / \
+		(STRESS_SENSORS * 50000LL) + 1)
+
+/* Sensors with faults during the run, and one with faults only before it */
+#define STRESS_CRC_FAULTY								13
+#define STRESS_CRC_FAULT_PERIOD					97
+#define STRESS_NACK_FAULTY							42
+#define STRESS_NACK_FAULT_PERIOD				101
+#define STRESS_FAULTY_BEFORE						0
+
+/* Private variables ---------------------------------------------------------*/
+static sgp41_sim_clock_t clock;
+static sgp41_sim_bus_t buses[STRESS_BUSES];
+static sgp41_sim_device_t devs[STRESS_SENSORS];
+static sgp41_sim_port_t ports[STRESS_SENSORS];
+static sgp41_t sensors[STRESS_SENSORS];
+static sgp41_t *instances[STRESS_SENSORS];
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that returns an integer field of a JSON line
+ *
+ * @param line : Pointer to the line
+ * @param name : Field name
+ *
+ * @return Field value, -1 if the line has no such field
+ */
+static int64_t stress_field(const char *line, const char *name);
+
+/**
+ * @brief Function that finds the error line of an instance in the output
+ *
+ * @param output : Pointer to the output of the benchmark
+ * @param id     : Instance number
+ *
+ * @return Pointer to the line, NULL if the instance has none
+ */
+static const char *stress_errors_line(const char *output, uint16_t id);
+
+/* Main ----------------------------------------------------------------------*/
+int main(void) {
+	sgp41_sim_clock_init(&clock, STRESS_START_US);
+	sgp41_set_clock(&clock.hook);
+
+	for (uint8_t i = 0; i < STRESS_SENSORS; i++) {
+		sgp41_sim_bus_t *bus = &buses[i / SGP41_SIM_MUX_CHANNELS];
+
+		if (i % SGP41_SIM_MUX_CHANNELS == 0) {
+			sgp41_sim_bus_init(bus, &clock);
+		}
+
+		sgp41_sim_device_init(&devs[i], &clock, 0x1000u + i);
+		esp_err_t ret = sgp41_init_with_transport(&sensors[i], sgp41_sim_attach(
+				&ports[i], bus, i % SGP41_SIM_MUX_CHANNELS, &devs[i]));
+
+		if (ret != ESP_OK) {
+			printf("FAIL: sensor %u init, %s\n", i, esp_err_to_name(ret));
+			return 1;
+		}
+
+		instances[i] = &sensors[i];
+	}
+
+	/* Errors before the run must not be reported by it */
+	uint16_t sraw_voc, sraw_nox;
+	devs[STRESS_FAULTY_BEFORE].crc_fault_period = 1;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		sgp41_measure_raw_signals(&sensors[STRESS_FAULTY_BEFORE], SGP41_DEFAULT_RH,
+				SGP41_DEFAULT_T, &sraw_voc, &sraw_nox);
+	}
+
+	devs[STRESS_FAULTY_BEFORE].crc_fault_period = 0;
+	devs[STRESS_CRC_FAULTY].crc_fault_period = STRESS_CRC_FAULT_PERIOD;
+	devs[STRESS_NACK_FAULTY].nack_fault_period = STRESS_NACK_FAULT_PERIOD;
+
+	uint32_t reads_before = devs[STRESS_CRC_FAULTY].reads;
+	uint32_t writes_before = devs[STRESS_NACK_FAULTY].writes;
+	int64_t start_us = clock.now_us;
+	char *output;
+	size_t output_len;
+	FILE *stream = open_memstream(&output, &output_len);
+
+	esp_err_t ret = sgp41_benchmark_stress(instances, STRESS_SENSORS,
+			STRESS_ROUNDS, stream);
+	fclose(stream);
+	fputs(output, stdout);
+
+	if (ret != ESP_OK) {
+		printf("FAIL: %s\n", esp_err_to_name(ret));
+		return 1;
+	}
+
+	/* Faults the sensors injected during the run */
+	uint32_t crc_faults = devs[STRESS_CRC_FAULTY].reads / STRESS_CRC_FAULT_PERIOD -
+			reads_before / STRESS_CRC_FAULT_PERIOD;
+	uint32_t nack_faults = devs[STRESS_NACK_FAULTY].writes /
+			STRESS_NACK_FAULT_PERIOD - writes_before / STRESS_NACK_FAULT_PERIOD;
+	int failed = 0;
+
+	if (stress_field(output, "samples") !=
+			(int64_t)STRESS_SENSORS * STRESS_ROUNDS - crc_faults - nack_faults ||
+			stress_field(output, "crc_errors") != crc_faults ||
+			stress_field(output, "nacks") != nack_faults) {
+		printf("FAIL: expected %" PRIu32 " CRC errors and %" PRIu32 " NACKs\n",
+				crc_faults, nack_faults);
+		failed = 1;
+	}
+
+	if (clock.now_us - start_us < STRESS_DURATION_US ||
+			stress_field(output, "elapsed_us") != clock.now_us - start_us) {
+		printf("FAIL: the run took %" PRId64 " us of virtual time\n",
+				clock.now_us - start_us);
+		failed = 1;
+	}
+
+	/* Measuring allocates nothing */
+	if (stress_field(output, "heap_peak_bytes") != 0) {
+		printf("FAIL: heap used during the run\n");
+		failed = 1;
+	}
+
+	/* Per-instance errors are those of the run */
+	const char *crc_line = stress_errors_line(output,
+			sensors[STRESS_CRC_FAULTY].id);
+	const char *nack_line = stress_errors_line(output,
+			sensors[STRESS_NACK_FAULTY].id);
+
+	if (crc_line == NULL || nack_line == NULL ||
+			stress_field(crc_line, "crc_errors_word0") != crc_faults ||
+			stress_field(nack_line, "write_nacks") != nack_faults) {
+		printf("FAIL: faulty sensors not reported with the faults of the run\n");
+		failed = 1;
+	}
+
+	if (stress_errors_line(output, sensors[STRESS_FAULTY_BEFORE].id) != NULL) {
+		printf("FAIL: errors from before the run reported\n");
+		failed = 1;
+	}
+
+	for (uint8_t i = 0; i < STRESS_SENSORS; i++) {
+		if (devs[i].bad_frames != 0 || devs[i].early_reads != 0) {
+			printf("FAIL: sensor %u saw %" PRIu32 " bad frames and %" PRIu32
+					" early reads\n", i, devs[i].bad_frames, devs[i].early_reads);
+			failed = 1;
+		}
+
+		sgp41_deinit(&sensors[i]);
+	}
+
+	sgp41_set_clock(NULL);
+	free(output);
+	printf("%s\n", failed ? "FAIL" : "PASS");
+
+	return failed;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that returns an integer field of a JSON line
+ */
+static int64_t stress_field(const char *line, const char *name) {
+	char key[64];
+	snprintf(key, sizeof(key), "\"%s\":", name);
+
+	const char *end = strchr(line, '\n');
+	const char *field = strstr(line, key);
+
+	if (field == NULL || (end != NULL && field > end)) {
+		return -1;
+	}
+
+	return strtoll(field + strlen(key), NULL, 10);
+}
+
+/**
+ * @brief Function that finds the error line of an instance in the output
+ */
+static const char *stress_errors_line(const char *output, uint16_t id) {
+	char key[64];
+	snprintf(key, sizeof(key), "\"stress_errors\",\"instance\":%u,", id);
+
+	return strstr(output, key);
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Format SGP41 binary log records captured with sgp41_log_dump().
+
+The message table is read from sgp41_log_msgs.h, so the decoder always
+matches the firmware it was built from.
+
+Usage: sgp41_log_decode.py [--msgs sgp41_log_msgs.h] [capture.txt]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+DEFAULT_MSGS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            os.pardir, "sgp41_log_msgs.h")
+
+
+def load_messages(path):
+    """Return the list of format strings indexed by message ID."""
+    with open(path) as f:
+        text = f.read()
+
+    formats = dict(re.findall(r'#define\s+SGP41_MSG_(\w+)\s+"((?:[^"\\]|\\.)*)"',
+                              text))
+    table = re.search(r"#define\s+SGP41_LOG_MESSAGES\(X\)((?:.*\\\n)*.*)", text)
+    names = re.findall(r"X\((\w+)\)", table.group(1))
+
+    return [(name, formats[name]) for name in names]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--msgs", default=DEFAULT_MSGS,
+                        help="path to sgp41_log_msgs.h")
+    parser.add_argument("capture", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin,
+                        help="console capture containing sgp41_log lines")
+    args = parser.parse_args()
+
+    messages = load_messages(args.msgs)
+
+    for line in args.capture:
+        fields = line.split()
+
+        # Console captures mix other output with the log records
+        if len(fields) != 6 or fields[0] != "sgp41_log":
+            continue
+
+        timestamp_us, msg_id = int(fields[1]), int(fields[2])
+        values = tuple(int(v, 16) for v in fields[3:])
+
+        if msg_id >= len(messages):
+            print("%12.6f unknown message %d %s" %
+                  (timestamp_us / 1e6, msg_id, " ".join(fields[3:])))
+            continue
+
+        name, fmt = messages[msg_id]
+        count = len(re.findall(r"%[-0-9.]*[a-zA-Z]", fmt.replace("%%", "")))
+        print("%12.6f %s: %s" % (timestamp_us / 1e6, name,
+                                 fmt % values[:count]))
+
+
+if __name__ == "__main__":
+    main()
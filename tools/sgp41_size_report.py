@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Report the flash and RAM used by the SGP41 component per configuration.
+
+Each configuration is a set of sdkconfig options layered on top of the
+project's own defaults. The project is built once per configuration in its
+own build directory and the size of libsgp41.a is read from
+"idf.py size-components".
+
+Usage: sgp41_size_report.py [--project PATH] [--only NAME ...]
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+# Options not listed keep their Kconfig default
+CONFIGURATIONS = {
+    "minimal": {
+        "CONFIG_SGP41_CRC_BITWISE": "y",
+        "CONFIG_SGP41_WAIT_TASK_DELAY": "y",
+        "CONFIG_SGP41_SELF_TEST_AT_INIT": "n",
+        "CONFIG_SGP41_LOG_LEVEL_ERROR": "y",
+        "CONFIG_SGP41_METRICS": "n",
+    },
+    "default": {},
+    "table_crc": {
+        "CONFIG_SGP41_CRC_TABLE": "y",
+    },
+    "diagnostics": {
+        "CONFIG_SGP41_LATENCY_STATS": "y",
+        "CONFIG_SGP41_CPU_STATS": "y",
+        "CONFIG_SGP41_TRACE": "y",
+        "CONFIG_SGP41_BINARY_LOG": "y",
+    },
+    "full": {
+        "CONFIG_SGP41_CRC_TABLE": "y",
+        "CONFIG_SGP41_LATENCY_STATS": "y",
+        "CONFIG_SGP41_CPU_STATS": "y",
+        "CONFIG_SGP41_TRACE": "y",
+        "CONFIG_SGP41_HOOKS": "y",
+        "CONFIG_SGP41_PROMETHEUS": "y",
+        "CONFIG_SGP41_BENCHMARK": "y",
+    },
+}
+
+ARCHIVE = "libsgp41.a"
+
+
+def write_defaults(path, options):
+    """Write an sdkconfig fragment, "n" options are written as not set."""
+    with open(path, "w") as f:
+        for name, value in options.items():
+            if value == "n":
+                f.write("# %s is not set\n" % name)
+            else:
+                f.write("%s=%s\n" % (name, value))
+
+
+def sum_sizes(entry):
+    """Split the sizes of an archive entry in (flash, ram).
+
+    Memory type names differ between IDF versions ("flash_text", "dram_bss",
+    ".flash.rodata", ...), so they are classified by name.
+    """
+    flash = ram = 0
+
+    for key, value in entry.items():
+        name = key.lower()
+
+        if not isinstance(value, int) or name == "total":
+            continue
+
+        if "flash" in name:
+            flash += value
+        elif "ram" in name:
+            ram += value
+
+    return flash, ram
+
+
+def component_size(project, name, options):
+    """Build the project with the given options and return (flash, ram)."""
+    build_dir = os.path.join(project, "build_size_" + name)
+    os.makedirs(build_dir, exist_ok=True)
+
+    fragment = os.path.join(build_dir, "sdkconfig.sgp41")
+    write_defaults(fragment, options)
+
+    defaults = [fragment]
+    project_defaults = os.path.join(project, "sdkconfig.defaults")
+
+    if os.path.exists(project_defaults):
+        defaults.insert(0, project_defaults)
+
+    output = subprocess.run(
+        ["idf.py", "-B", build_dir,
+         "-D", "SDKCONFIG=" + os.path.join(build_dir, "sdkconfig"),
+         "-D", "SDKCONFIG_DEFAULTS=" + ";".join(defaults),
+         "size-components", "--format", "json"],
+        cwd=project, check=True, stdout=subprocess.PIPE,
+        universal_newlines=True).stdout
+
+    # The JSON document follows the build output
+    sizes = json.loads(output[output.index("{"):])
+
+    return sum_sizes(sizes[ARCHIVE])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--project", default=os.getcwd(),
+                        help="ESP-IDF project that uses the component")
+    parser.add_argument("--only", nargs="+", choices=sorted(CONFIGURATIONS),
+                        help="configurations to build, all by default")
+    args = parser.parse_args()
+
+    names = args.only or list(CONFIGURATIONS)
+
+    print("%-12s %10s %10s" % ("config", "flash", "ram"))
+
+    for name in names:
+        try:
+            flash, ram = component_size(args.project, name,
+                                        CONFIGURATIONS[name])
+        except (subprocess.CalledProcessError, KeyError, ValueError) as e:
+            print("%-12s failed: %s" % (name, e), file=sys.stderr)
+            continue
+
+        print("%-12s %10d %10d" % (name, flash, ram))
+
+
+if __name__ == "__main__":
+    main()
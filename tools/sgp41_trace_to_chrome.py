@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Convert SGP41 trace events captured with sgp41_trace_dump() to Chrome JSON.
+
+The command and phase names are read from include/sgp41.h and
+include/sgp41_codec.h, so the converter always matches the firmware it was
+built from. Load the output in
+chrome://tracing or Perfetto, each instance is shown as its own thread.
+
+Usage: sgp41_trace_to_chrome.py [--header sgp41.h] [capture.txt] > trace.json
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              os.pardir, "include", "sgp41.h")
+
+
+def load_enum(text, prefix, name):
+    """Return the lower case names of an enum, indexed by value."""
+    body = re.search(r"typedef enum \{([^}]*)\}\s*%s;" % name, text).group(1)
+    names = re.findall(r"%s_(\w+)" % prefix, body)
+
+    return [n.lower() for n in names if n != "MAX"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--header", default=DEFAULT_HEADER,
+                        help="path to sgp41.h")
+    parser.add_argument("capture", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin,
+                        help="console capture containing sgp41_trace lines")
+    args = parser.parse_args()
+
+    with open(args.header) as f:
+        text = f.read()
+
+    # The commands are declared by the codec, next to the driver header
+    codec = os.path.join(os.path.dirname(args.header), "sgp41_codec.h")
+
+    with open(codec) as f:
+        text += f.read()
+
+    commands = load_enum(text, "SGP41_CMD", "sgp41_cmd_t")
+    phases = load_enum(text, "SGP41_PHASE", "sgp41_phase_t")
+    events = []
+
+    for line in args.capture:
+        fields = line.split()
+
+        # Console captures mix other output with the trace events. Captures
+        # from before the status field have one field less
+        if len(fields) not in (6, 7) or fields[0] != "sgp41_trace":
+            continue
+
+        timestamp_us, duration_us, instance, command, phase = map(int,
+                                                                  fields[1:6])
+        status = int(fields[6]) if len(fields) == 7 else 0
+        command = commands[command] if command < len(commands) else command
+        phase = phases[phase] if phase < len(phases) else phase
+
+        event = {"name": "%s.%s" % (command, phase), "cat": "sgp41",
+                 "ph": "X", "ts": timestamp_us, "dur": duration_us,
+                 "pid": 0, "tid": instance}
+
+        # Failed phases carry the error that ended them, as esp_err_t
+        if status != 0:
+            event["args"] = {"status": "0x%x" % (status & 0xffffffff)}
+
+        events.append(event)
+
+    json.dump({"displayTimeUnit": "ms", "traceEvents": events}, sys.stdout,
+              indent=0)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()